@@ -3,28 +3,151 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 typedef void CURL;
 
 namespace SlCurl {
 
+class MultiCurl;
+
+/**
+ * @brief Statistics of one transfer
+ *
+ * The times are as reported by libcurl: each is measured from the start of the (last) attempt.
+ */
+struct TransferInfo {
+	/// @brief Body bytes received over the wire (compressed if the server compressed them)
+	uint64_t compressedBytes = 0;
+	/// @brief Body bytes delivered to the caller (decompressed)
+	uint64_t uncompressedBytes = 0;
+	/// @brief Average download speed in bytes per second
+	uint64_t bytesPerSec = 0;
+	/// @brief Time until the name was resolved
+	std::chrono::microseconds nameLookup {};
+	/// @brief Time until connected to the server
+	std::chrono::microseconds connect {};
+	/// @brief Time until the TLS handshake was done
+	std::chrono::microseconds TLSHandshake {};
+	/// @brief Time until the first byte was received
+	std::chrono::microseconds firstByte {};
+	/// @brief Time of the whole transfer
+	std::chrono::microseconds total {};
+	/// @brief Attempt number (starting at 1, see RetryPolicy)
+	unsigned attempt = 0;
+};
+
+/**
+ * @brief Retry policy for transient failures
+ *
+ * Failures to resolve or connect, timeouts, broken transfers, and HTTP 408, 429, and 5xx
+ * errors are considered transient. The n-th retry waits for \c initialDelay * 2^(n-1)
+ * (capped at \c maxDelay), randomized into the upper half of that interval if \c jitter
+ * is set.
+ */
+struct RetryPolicy {
+	/// @brief How many times to retry (0 = no retries)
+	unsigned maxRetries = 0;
+	/// @brief Delay before the first retry
+	std::chrono::milliseconds initialDelay { 500 };
+	/// @brief Maximal delay between retries
+	std::chrono::milliseconds maxDelay { 30000 };
+	/// @brief Randomize the delays
+	bool jitter = true;
+};
+
 /**
  * @brief Wrapper class for libcurl
  */
 class LibCurl {
 public:
+	/// @brief A callback for downloadChunks(), return false to abort the transfer
+	using ChunkCallback = std::function<bool (std::string_view chunk)>;
+	/// @brief A callback invoked after every attempt of every transfer
+	using TransferObserver = std::function<void (const std::string &url, bool success,
+						     const TransferInfo &info)>;
+
+	/// @brief One file for fetchFilesIfNeeded()
+	struct FetchEntry {
+		/// @brief File to store to
+		std::filesystem::path filePath;
+		/// @brief The URL to fetch
+		std::string url;
+		/// @brief After how many hours this file expires (and is downloaded again)
+		std::chrono::hours hours;
+	};
+
+	/**
+	 * @brief Outcome of fetchFilesIfNeeded() for one file
+	 *
+	 * STALE means the download failed, but the old file is still there.
+	 */
+	enum class FetchStatus {
+		FRESH,
+		DOWNLOADED,
+		STALE,
+		FAILED,
+	};
+
 	/**
 	 * @brief Construct LibCurl
 	 *
 	 * Either make a LibCurl and use non-static methods; or use the static methods.
+	 * Keep the LibCurl around for more downloads: connections, DNS and TLS sessions are
+	 * reused then.
 	 */
 	LibCurl();
 	~LibCurl();
 
+	LibCurl(const LibCurl &) = delete;
+	LibCurl &operator=(const LibCurl &) = delete;
+
+	/**
+	 * @brief Enable or disable compressed transfers (enabled by default)
+	 * @param enable Whether to ask servers for compressed content
+	 *
+	 * All encodings libcurl was built with (gzip, zstd, br, ...) are offered and the
+	 * received data are decompressed on the fly before they reach the caller.
+	 */
+	void setCompression(bool enable);
+
+	/// @brief Get statistics of the last transfer performed by this LibCurl
+	const TransferInfo &lastTransfer() const { return m_lastTransfer; }
+
+	/**
+	 * @brief Retry transient failures according to \p policy
+	 * @param policy The policy to use
+	 *
+	 * Transfers into a chunk callback are retried only if nothing was passed to the callback
+	 * yet. Streams are retried only if they are seekable.
+	 */
+	void setRetryPolicy(const RetryPolicy &policy) { m_retryPolicy = policy; }
+	/// @brief Invoke \p observer after every attempt of every transfer
+	void setObserver(const TransferObserver &observer) { m_observer = observer; }
+
+	/**
+	 * @brief Set RetryPolicy for LibCurls created from now on
+	 * @param policy The policy to use
+	 *
+	 * This includes the per-thread LibCurl used by the static methods if it was not used in
+	 * the thread yet. Not thread-safe, set this up before doing any downloads.
+	 */
+	static void setDefaultRetryPolicy(const RetryPolicy &policy) {
+		m_defaultRetryPolicy = policy;
+	}
+	/// @brief Set TransferObserver for LibCurls created from now on, see setDefaultRetryPolicy()
+	static void setDefaultObserver(const TransferObserver &observer) {
+		m_defaultObserver = observer;
+	}
+
 	/**
 	 * @brief Download \p url to \p stream
 	 * @param url URL to download
@@ -32,20 +155,43 @@ public:
 	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
 	 * @return true for success.
 	 */
-	bool downloadToStream(const std::string &url, const std::ostream &stream,
+	bool downloadToStream(const std::string &url, std::ostream &stream,
 			      unsigned *HTTPErrorCode = nullptr);
 
+	/**
+	 * @brief Download \p url and append to \p str
+	 * @param url URL to download
+	 * @param str String to append to (reserved according to Content-Length)
+	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
+	 * @return true for success.
+	 */
+	bool downloadToString(const std::string &url, std::string &str,
+			      unsigned *HTTPErrorCode = nullptr);
+
+	/**
+	 * @brief Download \p url and pass the data to \p CB as they arrive
+	 * @param url URL to download
+	 * @param CB Callback to invoke for every received chunk
+	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
+	 * @return true for success.
+	 *
+	 * The chunks are not split on any boundaries (like lines).
+	 */
+	bool downloadChunks(const std::string &url, const ChunkCallback &CB,
+			    unsigned *HTTPErrorCode = nullptr);
+
 	/**
 	 * @brief Download \p url to \p file
 	 * @param url URL to download
 	 * @param file Where to store the downloaded content to
 	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
 	 * @return true for success.
+	 *
+	 * The data are written directly using write(2).
 	 */
 	bool downloadToFile(const std::string &url, const std::filesystem::path &file,
 			    unsigned *HTTPErrorCode = nullptr);
 
-
 	/**
 	 * @brief Download \p url to a string
 	 * @param url URL to download
@@ -56,7 +202,7 @@ public:
 					    unsigned *HTTPErrorCode = nullptr);
 
 	/**
-	 * @brief Download \p url to a string (and create LibCurl temporarily)
+	 * @brief Download \p url to a string (using a per-thread LibCurl)
 	 * @param url URL to download
 	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
 	 * @return Downloaded content or nullopt on failure.
@@ -65,7 +211,7 @@ public:
 							 unsigned *HTTPErrorCode = nullptr);
 
 	/**
-	 * @brief Download \p url to \p file (and create LibCurl temporarily)
+	 * @brief Download \p url to \p file (using a per-thread LibCurl)
 	 * @param url URL to download
 	 * @param file Where to store the downloaded content to
 	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
@@ -100,10 +246,72 @@ public:
 						       bool forceRefresh, bool ignoreErrors,
 						       const std::chrono::hours &hours);
 
+	/**
+	 * @brief Fetch all \p files concurrently (those which are not recent enough)
+	 * @param files List of files to fetch
+	 * @param forceRefresh Fetch in any case (ignore FetchEntry::hours)
+	 * @param ignoreErrors Errors are ignored (and STALE is never returned)
+	 * @param maxParallel How many downloads can be in flight at once
+	 * @return Status for each of \p files (in the same order).
+	 *
+	 * This is a batch variant of fetchFileIfNeeded(). Each file is downloaded to a ".NEW"
+	 * file and renamed over the original only when the download succeeds.
+	 */
+	static std::vector<FetchStatus> fetchFilesIfNeeded(const std::vector<FetchEntry> &files,
+							   bool forceRefresh, bool ignoreErrors,
+							   unsigned maxParallel = 8);
+
 	/// @brief Return the last error string if some
 	static const std::string &lastError() { return m_lastError; }
 private:
+	friend class MultiCurl;
+
+	class Sink {
+	public:
+		using Target = std::variant<std::ostream *, std::string *, const ChunkCallback *,
+		      int>;
+
+		Sink(Target target) : m_target(target), m_handle(nullptr), m_start(0), m_written(0),
+			m_errno(0) {}
+
+		static size_t write(const char *contents, size_t size, size_t nmemb,
+				    void *userdata);
+
+		uint64_t written() const { return m_written; }
+		int writeErrno() const { return m_errno; }
+	private:
+		friend class LibCurl;
+
+		bool writeFD(int fd, std::string_view data);
+		void start();
+		bool rewind();
+
+		Target m_target;
+		CURL *m_handle;
+		int64_t m_start;
+		uint64_t m_written;
+		int m_errno;
+	};
+
+	static LibCurl &threadLocal();
+	static FetchStatus fetchDone(const std::filesystem::path &filePath,
+				     const std::filesystem::path &newPath, const std::string &url,
+				     bool fileAlreadyExists, bool ignoreErrors, bool success,
+				     unsigned http_code, const std::string &error);
+
+	bool perform(const std::string &url, Sink &&sink, unsigned *HTTPErrorCode);
+	void prepare(const std::string &url, Sink &sink);
+	bool finish(const std::string &url, int ret, const Sink &sink, unsigned attempt,
+		    unsigned *HTTPErrorCode, std::string &error);
+	bool shouldRetry(int ret, unsigned HTTPErrorCode, unsigned attempt, Sink &sink) const;
+	std::chrono::milliseconds retryDelay(unsigned attempt) const;
+
 	CURL *handle;
+	TransferInfo m_lastTransfer;
+	RetryPolicy m_retryPolicy;
+	TransferObserver m_observer;
+	static RetryPolicy m_defaultRetryPolicy;
+	static TransferObserver m_defaultObserver;
 	static thread_local std::string m_lastError;
 };
 
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Curl.h"
+
+typedef void CURLM;
+
+namespace SlCurl {
+
+/**
+ * @brief Long-lived client performing many downloads concurrently
+ *
+ * All transfers share one connection cache, so keep-alive connections are reused and HTTP/2
+ * streams are multiplexed over a single connection per host. DNS and TLS sessions are shared
+ * with all LibCurl instances.
+ * \code
+ * MultiCurl multi;
+ * for (const auto &branch : branches)
+ *	multi.add(urlFor(branch), [](MultiCurl::Result &&res) {
+ *		if (res.success)
+ *			process(res.content);
+ *	});
+ * multi.perform();
+ * \endcode
+ */
+class MultiCurl {
+public:
+	/// @brief Outcome of one transfer
+	struct Result {
+		/// @brief The URL downloaded
+		std::string url;
+		/// @brief Whether the transfer succeeded
+		bool success;
+		/// @brief HTTP error code returned from the server
+		unsigned HTTPErrorCode;
+		/// @brief Error string if the transfer failed
+		std::string error;
+		/// @brief Downloaded content (only when downloading to a string)
+		std::string content;
+		/// @brief Transfer statistics
+		TransferInfo info;
+	};
+
+	/// @brief A callback invoked when a transfer finishes
+	using DoneCallback = std::function<void (Result &&res)>;
+
+	/**
+	 * @brief Construct MultiCurl
+	 * @param maxParallel How many transfers can be in flight at once
+	 * @param http2 Use HTTP/2 (and multiplex transfers) if the server supports it
+	 * @param compression Ask servers for compressed content, see LibCurl::setCompression()
+	 */
+	MultiCurl(unsigned maxParallel = 8, bool http2 = true, bool compression = true);
+	~MultiCurl();
+
+	MultiCurl(const MultiCurl &) = delete;
+	MultiCurl &operator=(const MultiCurl &) = delete;
+
+	/**
+	 * @brief Retry transient failures according to \p policy
+	 * @param policy The policy to use
+	 *
+	 * Defaults to LibCurl::setDefaultRetryPolicy(). A transfer waiting for its retry does not
+	 * block the others.
+	 */
+	void setRetryPolicy(const RetryPolicy &policy) { m_retryPolicy = policy; }
+	/// @brief Invoke \p observer after every attempt of every transfer
+	void setObserver(const LibCurl::TransferObserver &observer) { m_observer = observer; }
+
+	/**
+	 * @brief Queue a download of \p url
+	 * @param url URL to download
+	 * @param CB Callback to invoke from perform() when the download finishes
+	 *
+	 * \p CB can queue further downloads. They are performed by the same perform() call.
+	 */
+	void add(const std::string &url, const DoneCallback &CB);
+
+	/**
+	 * @brief Queue a download of \p url to \p file
+	 * @param url URL to download
+	 * @param file Where to store the downloaded content to (using write(2))
+	 * @param CB Callback to invoke from perform() when the download finishes
+	 *
+	 * The file is opened only once the transfer starts.
+	 */
+	void add(const std::string &url, const std::filesystem::path &file,
+		 const DoneCallback &CB);
+
+	/**
+	 * @brief Queue a download of \p url, passing the data to \p chunkCB as they arrive
+	 * @param url URL to download
+	 * @param chunkCB Callback to invoke for every received chunk
+	 * @param CB Callback to invoke from perform() when the download finishes
+	 */
+	void add(const std::string &url, const LibCurl::ChunkCallback &chunkCB,
+		 const DoneCallback &CB);
+
+	/**
+	 * @brief Perform all queued downloads
+	 * @return true if all of them succeeded.
+	 */
+	bool perform();
+
+	/**
+	 * @brief Download \p url to a string (using the cached connections)
+	 * @param url URL to download
+	 * @param HTTPErrorCode HTTP error code returned from the server (or nullptr)
+	 * @return Downloaded content or nullopt on failure.
+	 *
+	 * Downloads queued by add() are performed too.
+	 */
+	std::optional<std::string> download(const std::string &url,
+					    unsigned *HTTPErrorCode = nullptr);
+
+	/// @brief Return the last error string if some
+	static const std::string &lastError() { return m_lastError; }
+private:
+	struct Request {
+		std::string url;
+		std::filesystem::path file;
+		LibCurl::ChunkCallback chunkCB;
+		DoneCallback CB;
+	};
+
+	struct Transfer {
+		Request req;
+		std::unique_ptr<LibCurl> curl;
+		std::string content;
+		int fd = -1;
+		LibCurl::Sink sink { &content };
+		unsigned attempt = 0;
+		std::chrono::steady_clock::time_point retryAt;
+	};
+
+	std::unique_ptr<LibCurl> getCurl();
+	bool startPending();
+	bool processDone();
+	void done(Transfer &transfer, Result &res);
+	void fail(CURL *handle, std::string error);
+	bool startRetries();
+	int pollTimeout() const;
+
+	CURLM *m_multi;
+	const unsigned m_maxParallel;
+	const bool m_http2;
+	const bool m_compression;
+	bool m_allOK;
+	std::deque<Request> m_pending;
+	std::unordered_map<CURL *, Transfer> m_running;
+	std::vector<CURL *> m_retrying;
+	RetryPolicy m_retryPolicy;
+	LibCurl::TransferObserver m_observer;
+	std::vector<std::unique_ptr<LibCurl>> m_idle;
+	static thread_local std::string m_lastError;
+};
+
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include <git2.h>
 
@@ -39,4 +40,40 @@ private:
 	explicit Blob(const Repo &repo, GitTy *blob) noexcept;
 };
 
+/**
+ * @brief Content of a Blob which keeps the Blob alive
+ *
+ * The content is not copied, the view points directly to the libgit2's buffer and is valid as
+ * long as this BlobView lives. It can be moved around freely.
+ * \code
+ * if (auto maint = repo.catFileView("origin/master", "MAINTAINERS"))
+ *	parse(*maint);
+ * \endcode
+ */
+class BlobView {
+public:
+	BlobView() = delete;
+	/// @brief Construct a BlobView holding \p blob
+	explicit BlobView(Blob &&blob) noexcept : m_blob(std::move(blob)),
+		m_view(m_blob.contentView()) {}
+
+	/// @brief Get the content
+	std::string_view view() const noexcept { return m_view; }
+	/// @brief Alias for view() -- implicit conversion
+	operator std::string_view() const noexcept { return m_view; }
+
+	/// @brief Get a pointer to the content
+	const char *data() const noexcept { return m_view.data(); }
+	/// @brief Get size of the content
+	size_t size() const noexcept { return m_view.size(); }
+	/// @brief Test whether the content is empty
+	bool empty() const noexcept { return m_view.empty(); }
+
+	/// @brief Get the Blob held by this BlobView
+	const Blob &blob() const noexcept { return m_blob; }
+private:
+	Blob m_blob;
+	std::string_view m_view;
+};
+
 }
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <git2.h>
+
+#include "Blob.h"
+#include "Helpers.h"
+
+namespace SlGit {
+
+class Repo;
+class Tree;
+
+/**
+ * @brief Cat many (revision, path) pairs at once
+ *
+ * Unlike calling Repo::catFile() for every pair, every revision is resolved only once, trees
+ * are looked up once per their OID (so subtrees shared among revisions are read once) and each
+ * distinct blob is read once. The contents are returned as string_views into the blobs, which
+ * are held by CatFiles.
+ * \code
+ * CatFiles cat(repo);
+ * std::vector<size_t> idx;
+ * for (const auto &branch : branches)
+ *	idx.push_back(cat.add(branch, "rpm/config.sh"));
+ * if (!cat.run())
+ *	return false;
+ * for (auto i : idx)
+ *	if (auto content = cat.content(i))
+ *		parse(*content);
+ * \endcode
+ */
+class CatFiles {
+public:
+	/// @brief Statistics of run()
+	struct Stats {
+		/// @brief Count of distinct revisions resolved
+		size_t revs;
+		/// @brief Count of trees read
+		size_t trees;
+		/// @brief Count of distinct blobs read
+		size_t blobs;
+	};
+
+	/// @brief Prepare a batch for \p repo (which must outlive CatFiles)
+	CatFiles(const Repo &repo) : m_repo(repo), m_stats{} {}
+
+	CatFiles(const CatFiles &) = delete;
+	CatFiles &operator=(const CatFiles &) = delete;
+
+	/**
+	 * @brief Queue \p path in \p rev
+	 * @param rev Revision (branch, tag, SHA, ...)
+	 * @param path Path to a file in \p rev
+	 * @return Index to pass to content().
+	 */
+	size_t add(const std::string &rev, const std::string &path);
+
+	/**
+	 * @brief Resolve all the queued pairs
+	 * @return true on success, false on a failure to read some object (see Repo::lastError()).
+	 *
+	 * Nonexistent revisions or paths are not failures, content() returns nullopt for them.
+	 */
+	bool run() noexcept;
+
+	/**
+	 * @brief Get the content of the \p idx-th pair (valid while this CatFiles lives)
+	 * @param idx Index returned from add()
+	 * @return Content, or nullopt if the revision or the file does not exist.
+	 */
+	std::optional<std::string_view> content(size_t idx) const noexcept {
+		if (const auto blob = m_requests[idx].blob)
+			return blob->contentView();
+		return std::nullopt;
+	}
+
+	/// @brief Get the Blob of the \p idx-th pair, or nullptr
+	const Blob *blob(size_t idx) const noexcept { return m_requests[idx].blob; }
+
+	/// @brief Get count of the queued pairs
+	size_t size() const noexcept { return m_requests.size(); }
+
+	/// @brief Get statistics of the last run()
+	const Stats &stats() const noexcept { return m_stats; }
+private:
+	struct Request {
+		std::string rev;
+		std::string path;
+		const Blob *blob;
+	};
+
+	using Blobs = std::unordered_map<git_oid, Blob, Helpers::OidHash, Helpers::OidEqual>;
+	using Trees = std::unordered_map<git_oid, Tree, Helpers::OidHash, Helpers::OidEqual>;
+
+	const Tree *getTree(Trees &trees, const git_oid &oid) noexcept;
+	bool resolvePath(Trees &trees, git_oid oid, std::string_view path,
+			 std::optional<git_oid> &blobId) noexcept;
+
+	const Repo &m_repo;
+	std::vector<Request> m_requests;
+	Blobs m_blobs;
+	Stats m_stats;
+};
+
+}
@@ -7,6 +7,7 @@
 
 #include <git2.h>
 
+#include "Blob.h"
 #include "Helpers.h"
 #include "Object.h"
 
@@ -65,6 +66,8 @@ public:
 
 	/// @brief Cat a \p file in this Commit's tree
 	std::optional<std::string> catFile(const std::string &file) const noexcept;
+	/// @brief Cat a \p file in this Commit's tree, without copying its content
+	std::optional<BlobView> catFileView(const std::string &file) const noexcept;
 
 	/// @brief Get the stored pointer to libgit2's git_commit
 	GitTy *commit() const noexcept { return typed(); }
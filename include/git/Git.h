@@ -3,13 +3,19 @@
 #pragma once
 
 #include "Blob.h"
+#include "CatFiles.h"
 #include "Commit.h"
 #include "Diff.h"
 #include "Helpers.h"
 #include "Index.h"
+#include "MetricsFetchCallbacks.h"
 #include "Misc.h"
 #include "PathSpec.h"
 #include "Remote.h"
 #include "Repo.h"
+#include "RepoPool.h"
 #include "Tag.h"
 #include "Tree.h"
+#include "TreeChanges.h"
+#include "TreeScan.h"
+#include "Updater.h"
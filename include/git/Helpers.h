@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <optional>
 #include <string>
 
@@ -30,6 +31,24 @@ public:
 			return std::nullopt;
 		return oid;
 	}
+
+	/// @brief Hash for git_oid keys of unordered containers
+	struct OidHash {
+		/// @brief Compute the hash of \p oid (its prefix, it is a SHA already)
+		size_t operator()(const git_oid &oid) const noexcept {
+			size_t hash;
+			std::memcpy(&hash, oid.id, sizeof(hash));
+			return hash;
+		}
+	};
+
+	/// @brief Equality for git_oid keys of unordered containers
+	struct OidEqual {
+		/// @brief Compare \p a and \p b
+		bool operator()(const git_oid &a, const git_oid &b) const noexcept {
+			return git_oid_equal(&a, &b);
+		}
+	};
 };
 
 }
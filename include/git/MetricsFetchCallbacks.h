@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "DefaultFetchCallbacks.h"
+
+namespace SlGit {
+
+/**
+ * @brief FetchCallbacks recording the progress of a fetch for later evaluation
+ *
+ * The transfer progress reported by libgit2 is sampled (at most once per the interval passed
+ * to the constructor, and at every phase change) into samples(). summary() computes the
+ * durations of the phases and the throughput. Credentials are handled by DefaultFetchCallbacks,
+ * the textual progress is printed only if requested.
+ * \code
+ * MetricsFetchCallbacks fc;
+ * if (!remote->fetchRefspecs(fc))
+ *	return false;
+ * const auto sum = fc.summary();
+ * log(sum.total, sum.bytes, sum.receiveBytesPerSec, sum.objectsPerSec);
+ * \endcode
+ */
+class MetricsFetchCallbacks : public DefaultFetchCallbacks {
+public:
+	/// @brief The clock used for the measurements
+	using Clock = std::chrono::steady_clock;
+
+	/// @brief Phase of the fetch
+	enum class Phase {
+		RECEIVING,	///< Receiving (and indexing) objects
+		RESOLVING,	///< Resolving deltas (all objects were received)
+	};
+
+	/// @brief One point of the time series
+	struct Sample {
+		/// @brief Time since the construction (or reset())
+		Clock::duration at;
+		/// @brief Phase at the time
+		Phase phase;
+		/// @brief Count of objects to receive
+		size_t totalObjects;
+		/// @brief Count of objects received so far
+		size_t receivedObjects;
+		/// @brief Count of objects indexed so far
+		size_t indexedObjects;
+		/// @brief Count of objects found locally (in a thin pack)
+		size_t localObjects;
+		/// @brief Count of deltas to resolve
+		size_t totalDeltas;
+		/// @brief Count of deltas resolved so far
+		size_t indexedDeltas;
+		/// @brief Count of bytes received so far
+		size_t receivedBytes;
+	};
+
+	/// @brief Evaluation of the fetch, see summary()
+	struct Summary {
+		/// @brief Time from the start to the last progress report
+		std::chrono::milliseconds total;
+		/// @brief Time of Phase::RECEIVING
+		std::chrono::milliseconds receiving;
+		/// @brief Time of Phase::RESOLVING
+		std::chrono::milliseconds resolving;
+		/// @brief Count of received objects
+		size_t objects;
+		/// @brief Count of objects found locally
+		size_t localObjects;
+		/// @brief Count of resolved deltas
+		size_t deltas;
+		/// @brief Count of received bytes
+		size_t bytes;
+		/// @brief Bytes per second over the whole fetch
+		double bytesPerSec;
+		/// @brief Bytes per second in Phase::RECEIVING
+		double receiveBytesPerSec;
+		/// @brief Objects per second in Phase::RECEIVING
+		double objectsPerSec;
+		/// @brief Deltas per second in Phase::RESOLVING
+		double deltasPerSec;
+	};
+
+	/**
+	 * @brief Construct MetricsFetchCallbacks
+	 * @param print Print the progress like DefaultFetchCallbacks too
+	 * @param interval Minimal time between two samples
+	 */
+	MetricsFetchCallbacks(bool print = false,
+			      Clock::duration interval = std::chrono::milliseconds(100)) :
+		m_print(print), m_interval(interval) { reset(); }
+
+	/// @brief Drop the collected samples and start measuring from now
+	void reset() noexcept;
+
+	virtual void checkoutProgress(std::string_view path, size_t completedSteps,
+				      size_t totalSteps) override {
+		if (m_print)
+			DefaultFetchCallbacks::checkoutProgress(path, completedSteps, totalSteps);
+	}
+	virtual int packProgress(int stage, uint32_t current, uint32_t total) override {
+		return m_print ? DefaultFetchCallbacks::packProgress(stage, current, total) : 0;
+	}
+	virtual int sidebandProgress(std::string_view str) override {
+		return m_print ? DefaultFetchCallbacks::sidebandProgress(str) : 0;
+	}
+	virtual int transferProgress(const git_indexer_progress &stats) override;
+	virtual int updateRefs(std::string_view refname, const git_oid &a, const git_oid &b,
+			       git_refspec &refspec) override {
+		return m_print ? DefaultFetchCallbacks::updateRefs(refname, a, b, refspec) : 0;
+	}
+
+	/// @brief Get the recorded time series
+	const std::vector<Sample> &samples() const noexcept { return m_samples; }
+
+	/// @brief Compute the summary of the fetch (all zeros if nothing was transferred)
+	Summary summary() const noexcept;
+private:
+	const bool m_print;
+	const Clock::duration m_interval;
+
+	Clock::time_point m_start;
+	std::optional<Sample> m_last;
+	std::optional<Clock::duration> m_receivedAt;
+	std::vector<Sample> m_samples;
+};
+
+}
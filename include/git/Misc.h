@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include <git2.h>
 
@@ -51,6 +54,18 @@ class Commit;
 
 /**
  * @brief RevWalk is a representation of a git revwalk
+ *
+ * Besides next(), which looks up every Commit, the walk can be consumed by OIDs only using
+ * nextId(). Both are also available as ranges:
+ * \code
+ * auto walk = repo.revWalkCreate();
+ * walk->pushRange("v6.1..v6.2");
+ * for (const auto &oid : walk->ids())
+ *	seen.insert(oid);
+ * \endcode
+ *
+ * libgit2 uses the commit-graph file (see Repo::commitGraphWrite()) for walking whenever it is
+ * present.
  */
 class RevWalk {
 	using GitTy = git_revwalk;
@@ -58,6 +73,69 @@ class RevWalk {
 
 	friend class Repo;
 public:
+	/**
+	 * @brief Input range over a RevWalk, see ids() and commits()
+	 *
+	 * Iterating advances the RevWalk. The iteration stops at the end of the walk or on an
+	 * error; Repo::lastErrno() is \c GIT_ITEROVER in the former case.
+	 */
+	template<typename T>
+	class Range {
+	public:
+		/// @brief Input iterator over the RevWalk
+		class iterator {
+		public:
+			/// @brief Iterator category
+			using iterator_category = std::input_iterator_tag;
+			/// @brief Value type
+			using value_type = T;
+			/// @brief Difference type
+			using difference_type = std::ptrdiff_t;
+
+			iterator() : m_walk(nullptr) {}
+
+			/// @brief Get the current item
+			const T &operator*() const noexcept { return *m_cur; }
+			/// @brief Access the current item
+			const T *operator->() const noexcept { return &*m_cur; }
+
+			/// @brief Move to the next item
+			iterator &operator++() noexcept { advance(); return *this; }
+			/// @brief Move to the next item
+			void operator++(int) noexcept { advance(); }
+
+			/// @brief Test whether the walk is over
+			bool operator==(std::default_sentinel_t) const noexcept { return !m_cur; }
+		private:
+			friend class Range;
+			explicit iterator(const RevWalk *walk) noexcept : m_walk(walk) { advance(); }
+
+			void advance() noexcept {
+				m_cur.reset();
+				if constexpr (std::is_same_v<T, git_oid>) {
+					if (const auto oid = m_walk->nextId())
+						m_cur.emplace(*oid);
+				} else {
+					if (auto commit = m_walk->next())
+						m_cur.emplace(std::move(*commit));
+				}
+			}
+
+			const RevWalk *m_walk;
+			std::optional<T> m_cur;
+		};
+
+		/// @brief Start iterating (fetches the first item)
+		iterator begin() const noexcept { return iterator(m_walk); }
+		/// @brief The end of the walk
+		std::default_sentinel_t end() const noexcept { return {}; }
+	private:
+		friend class RevWalk;
+		explicit Range(const RevWalk *walk) noexcept : m_walk(walk) {}
+
+		const RevWalk *m_walk;
+	};
+
 	RevWalk() = delete;
 
 	/// @brief Add one OID to this RevWalk
@@ -93,6 +171,15 @@ public:
 	bool hideGlob(const std::string &glob) const noexcept {
 		return !Repo::setLastError(git_revwalk_hide_glob(revWalk(), glob.c_str()));
 	}
+	/**
+	 * @brief Stop this RevWalk at commits older than \p time
+	 * @param time Cutoff in seconds since the epoch (see Commit::time())
+	 * @return true on success.
+	 *
+	 * libgit2 does not expose generation numbers, so the commit time is used as the cutoff
+	 * instead. A hidden commit hides also its ancestors.
+	 */
+	bool hideOlderThan(git_time_t time) noexcept;
 
 	/// @brief Set \p mode as sorting mode (\c GIT_SORT_NONE, \c GIT_SORT_TOPOLOGICAL, ...)
 	bool sorting(unsigned int mode) const noexcept {
@@ -101,17 +188,37 @@ public:
 
 	/// @brief Get next Commit in this RevWalk, or nullopt if there are no more
 	std::optional<Commit> next() const noexcept;
+	/// @brief Get OID of the next commit in this RevWalk, or nullopt if there are no more
+	std::optional<git_oid> nextId() const noexcept {
+		git_oid oid;
+		if (Repo::setLastError(git_revwalk_next(&oid, revWalk())))
+			return std::nullopt;
+		return oid;
+	}
+
+	/// @brief Iterate OIDs of this RevWalk (cheap, nothing is looked up)
+	Range<git_oid> ids() const noexcept { return Range<git_oid>(this); }
+	/// @brief Iterate Commits of this RevWalk
+	Range<Commit> commits() const noexcept { return Range<Commit>(this); }
 
 	/// @brief Get the stored pointer to libgit2's git_revwalk
 	GitTy *revWalk() const noexcept { return m_revWalk.get(); }
 	/// @brief Alias for revWalk() -- implicit conversion
 	operator GitTy *() const noexcept { return revWalk(); }
 private:
+	struct HideCutoff {
+		const Repo *repo;
+		git_time_t time;
+	};
+
 	explicit RevWalk(const Repo &repo, GitTy *revWalk) noexcept :
 		m_repo(repo), m_revWalk(revWalk) { }
 
+	static int hideCB(const git_oid *oid, void *payload);
+
 	const Repo &m_repo;
 	Holder m_revWalk;
+	std::unique_ptr<HideCutoff> m_hideCutoff;
 };
 
 /**
@@ -14,6 +14,7 @@
 namespace SlGit {
 
 class Repo;
+class StrArray;
 
 /**
  * @brief Remote is a representation of a git remote
@@ -24,11 +25,36 @@ class Remote {
 
 	friend class Repo;
 public:
+	/**
+	 * @brief Options for fetchRefspecs()
+	 *
+	 * libgit2 supports neither partial clones (object filters like \c blob:none) nor tuning
+	 * of the negotiation, so the amount of transferred data can be limited only by refspecs,
+	 * \p depth and \p tags.
+	 */
+	struct FetchOptions {
+		/// @brief How deep to fetch (or zero to fetch whole history)
+		int depth = 0;
+		/// @brief Fetch also tags?
+		bool tags = true;
+		/// @brief Remove remote-tracking references which no longer exist on the remote
+		bool prune = false;
+		/// @brief Write FETCH_HEAD?
+		bool updateFetchHead = true;
+		/// @brief Extra HTTP headers ("Name: value") sent to the remote
+		std::vector<std::string> customHeaders;
+	};
+
 	Remote() = delete;
 
+	/// @brief Fetch \p refspecs from this Remote using \p opts, invoking the \p fc callback
+	bool fetchRefspecs(FetchCallbacks &fc, const std::vector<std::string> &refspecs,
+			   const FetchOptions &opts) const noexcept;
 	/// @brief Fetch \p refspecs from this Remote, invoking the \p fc callback
 	bool fetchRefspecs(FetchCallbacks &fc, const std::vector<std::string> &refspecs = {},
-			   int depth = 0, bool tags = true) const noexcept;
+			   int depth = 0, bool tags = true) const noexcept {
+		return fetchRefspecs(fc, refspecs, FetchOptions { .depth = depth, .tags = tags });
+	}
 	/// @brief Fetch \p refspecs from this Remote
 	bool fetchRefspecs(const std::vector<std::string> &refspecs = {}, int depth = 0,
 			   bool tags = true) const noexcept {
@@ -55,6 +81,10 @@ public:
 private:
 	explicit Remote(GitTy *remote) noexcept : m_remote(remote) { }
 
+	static void setupFetchOptions(git_fetch_options &out, FetchCallbacks &fc,
+				      const FetchOptions &opts,
+				      const StrArray &customHeaders) noexcept;
+
 	static int fetchCredentials(git_credential **out, const char *url,
 				    const char *usernameFromUrl, unsigned int allowedTypes,
 				    void *payload) noexcept;
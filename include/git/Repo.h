@@ -18,6 +18,7 @@
 namespace SlGit {
 
 class Blob;
+class BlobView;
 class Commit;
 class Diff;
 class Index;
@@ -46,6 +47,24 @@ class Repo {
 	using GitTy = git_repository;
 	using Holder = SlHelpers::UniqueHolder<GitTy>;
 public:
+	/// @brief Options for clone()
+	struct CloneOptions {
+		/// @brief Branch to download (or empty string)
+		std::string branch;
+		/// @brief How deep to download (or zero to download whole history)
+		unsigned int depth = 0;
+		/// @brief Download also tags?
+		bool tags = true;
+		/// @brief Create a bare repository (no sources, only git files)
+		bool bare = false;
+		/// @brief Check out the sources (when not \p bare)
+		bool checkout = true;
+		/// @brief How to clone local repositories (\c GIT_CLONE_LOCAL_AUTO hardlinks objects)
+		git_clone_local_t local = GIT_CLONE_LOCAL_AUTO;
+		/// @brief Extra HTTP headers ("Name: value") sent to the remote
+		std::vector<std::string> customHeaders;
+	};
+
 	Repo() = delete;
 
 	/**
@@ -76,7 +95,26 @@ public:
 					 FetchCallbacks &fc,
 					 const std::string &branch = "",
 					 const unsigned int &depth = 0,
-					 bool tags = true) noexcept;
+					 bool tags = true) noexcept {
+		return clone(path, url, fc, CloneOptions { .branch = branch, .depth = depth,
+							   .tags = tags });
+	}
+	/**
+	 * @brief clone Clone (and open) an existing repository
+	 * @param path Path where to create the repository
+	 * @param url URL where to download from
+	 * @param fc Fetch callbacks, see FetchCallbacks
+	 * @param opts Options, see CloneOptions
+	 * @return Repo on success, nullopt otherwise.
+	 *
+	 * To save data and time when only the history is needed, clone with \c bare set (or
+	 * \c checkout unset). Local repositories (e.g. mirrors) are cloned by hardlinking their
+	 * objects by default.
+	 *
+	 * @code{.sh} git clone @endcode
+	 */
+	static std::optional<Repo> clone(const std::filesystem::path &path, const std::string &url,
+					 FetchCallbacks &fc, const CloneOptions &opts) noexcept;
 	/**
 	 * @brief clone Clone (and open) an existing repository
 	 * @param path Path where to create the repository
@@ -109,6 +147,8 @@ public:
 	 * @param remote Remote to update
 	 * @return true on success.
 	 *
+	 * See Updater to update several repositories concurrently.
+	 *
 	 * @code{.sh} git remote-update @endcode
 	 */
 	static bool update(const std::filesystem::path &path, const std::string &remote = "origin");
@@ -129,6 +169,14 @@ public:
 	 */
 	std::optional<std::string> catFile(const std::string &branch,
 					   const std::string &file) const noexcept;
+	/**
+	 * @brief Cat a \p file in a \p branch, without copying its content
+	 * @param branch Branch where to look
+	 * @param file File to get content of
+	 * @return BlobView holding the file content.
+	 */
+	std::optional<BlobView> catFileView(const std::string &branch,
+					    const std::string &file) const noexcept;
 
 	/// @brief Parse \p rev as either blob, commit, tag, or tree
 	std::variant<Blob, Commit, Tag, Tree, std::monostate>
@@ -222,6 +270,16 @@ public:
 	/// @brief Create a new RevWalk
 	std::optional<RevWalk> revWalkCreate() const noexcept;
 
+	/**
+	 * @brief Write (or refresh) the commit-graph file covering all references
+	 * @return true on success.
+	 *
+	 * libgit2 then uses the file to speed up RevWalk.
+	 */
+	bool commitGraphWrite() const noexcept;
+	/// @brief Test whether this repository has a commit-graph file
+	bool hasCommitGraph() const noexcept;
+
 	/// @brief Create a new Tag called \p tagName, pointing at \p target
 	std::optional<Tag> tagCreate(const std::string &tagName, const Object &target,
 				     const Signature &tagger, const std::string &message,
@@ -247,6 +305,8 @@ public:
 	std::filesystem::path path() const noexcept { return git_repository_path(repo()); }
 	/// @brief Get the path to sources
 	std::filesystem::path workDir() const noexcept { return git_repository_workdir(repo()); }
+	/// @brief Test whether this repository is bare (has no sources)
+	bool isBare() const noexcept { return git_repository_is_bare(repo()); }
 
 	/// @brief Return the last error string if some (from git_last_error())
 	static auto &lastError() noexcept { return m_lastError.lastError(); }
@@ -268,11 +328,13 @@ private:
 	friend class PathSpec;
 	friend class Reference;
 	friend class Remote;
+	friend class RepoPool;
 	friend class RevWalk;
 	friend class Signature;
 	friend class Tag;
 	friend class Tree;
 	friend class TreeBuilder;
+	friend class TreeChanges;
 
 	static std::pair<std::string, int> lastGitError() noexcept;
 
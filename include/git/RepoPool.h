@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+
+#include <git2.h>
+
+#include "Repo.h"
+
+namespace SlGit {
+
+/**
+ * @brief A pool of per-thread Repo handles to one repository
+ *
+ * libgit2 objects cannot be shared among threads, so every thread needs its own Repo. get()
+ * opens one lazily for the calling thread and returns the same one on subsequent calls from that
+ * thread. The handles live until the pool dies (or release() is called from the thread).
+ *
+ * Every handle has its own libgit2 object cache, so an object used in several threads is cached
+ * once per thread. Only the cache limits and the accounting of the cached memory are global to
+ * the process, hence setCacheLimits(), enableCache(), and cacheStats() are static and affect (or
+ * report) all the repositories opened in the process, not only this pool.
+ * \code
+ * RepoPool::setCacheLimits({ .maxSize = 512 << 20, .blobLimit = 64 << 10 });
+ * RepoPool pool(repoPath);
+ * // in some thread
+ * auto repo = pool.get();
+ * if (!repo)
+ *	return false;
+ * auto blob = repo->blobLookup(oid);
+ * \endcode
+ */
+class RepoPool {
+public:
+	/// @brief Limits of the libgit2 caches, see setCacheLimits()
+	struct CacheLimits {
+		/// @brief Total size of all the object caches (of all the repositories) in bytes
+		std::optional<ssize_t> maxSize;
+		/// @brief Largest blob in bytes to cache
+		std::optional<size_t> blobLimit;
+		/// @brief Largest tree in bytes to cache
+		std::optional<size_t> treeLimit;
+		/// @brief Largest commit in bytes to cache
+		std::optional<size_t> commitLimit;
+		/// @brief Largest tag in bytes to cache
+		std::optional<size_t> tagLimit;
+		/// @brief Total size of mmapped pack windows in bytes
+		std::optional<size_t> mwindowMappedLimit;
+	};
+
+	/// @brief Process-wide statistics of the libgit2 object caches, see cacheStats()
+	struct CacheStats {
+		/// @brief Bytes currently held in the caches of all the repositories
+		ssize_t used;
+		/// @brief Bytes allowed in the caches of all the repositories
+		ssize_t allowed;
+	};
+
+	/// @brief Statistics of this RepoPool, see stats()
+	struct Stats {
+		/// @brief Count of handles opened (one per thread)
+		size_t opened;
+		/// @brief Count of get() calls
+		uint64_t gets;
+		/// @brief The process-wide cache statistics (not only of this pool)
+		CacheStats cache;
+	};
+
+	/// @brief Prepare a pool for the repository at \p path (nothing is opened yet)
+	RepoPool(const std::filesystem::path &path) : m_path(path), m_gets(0) {}
+
+	RepoPool(const RepoPool &) = delete;
+	RepoPool &operator=(const RepoPool &) = delete;
+
+	/**
+	 * @brief Get the Repo of the calling thread, open it if needed
+	 * @return Repo, or nullptr on failure (see Repo::lastError()).
+	 *
+	 * The returned Repo must be used only in the calling thread.
+	 */
+	const Repo *get() noexcept;
+
+	/// @brief Close the Repo of the calling thread (if any)
+	void release() noexcept;
+
+	/// @brief Get the path this pool opens
+	const std::filesystem::path &path() const noexcept { return m_path; }
+
+	/// @brief Get statistics of this pool and of the process-wide caching
+	Stats stats() const noexcept;
+
+	/**
+	 * @brief Set limits of the libgit2 caches (for all the repositories in the process)
+	 * @param limits Limits to set, unset members are not changed
+	 * @return true on success.
+	 */
+	static bool setCacheLimits(const CacheLimits &limits) noexcept;
+
+	/// @brief Enable or disable the libgit2 object caches (of all the repositories)
+	static bool enableCache(bool enable) noexcept;
+
+	/// @brief Get memory used by the object caches of all the repositories in the process
+	static std::optional<CacheStats> cacheStats() noexcept;
+private:
+	const std::filesystem::path m_path;
+
+	mutable std::mutex m_lock;
+	std::unordered_map<std::thread::id, std::unique_ptr<Repo>> m_repos;
+	std::atomic<uint64_t> m_gets;
+};
+
+}
@@ -4,20 +4,23 @@
 
 #include <filesystem>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include <git2.h>
 
 #include "../helpers/Unique.h"
 
+#include "Blob.h"
 #include "Helpers.h"
 #include "Object.h"
 #include "Repo.h"
 
 namespace SlGit {
 
-class Blob;
 class Commit;
 class TreeEntry;
 
@@ -40,19 +43,38 @@ public:
 
 	/// @brief Walk this Tree and call \p CB for every entry
 	bool walk(const WalkCallback &CB, const git_treewalk_mode &mode = GIT_TREEWALK_PRE) const;
+	/**
+	 * @brief Walk this Tree and call \p CB for every entry
+	 * @param CB Any callable accepting (std::string_view root, const TreeEntry &entry)
+	 * @param mode \c GIT_TREEWALK_PRE or \c GIT_TREEWALK_POST
+	 * @return true on success.
+	 *
+	 * Unlike the WalkCallback variant, \p CB is neither wrapped in std::function nor copied,
+	 * and no string is allocated per entry. Use TreeEntry::nameSV() to get the entry name for
+	 * free. Both \p root and the entry are valid only during the call.
+	 */
+	template<typename Callback>
+	requires std::is_invocable_r_v<int, Callback &, std::string_view, const TreeEntry &>
+	bool walk(Callback &&CB, git_treewalk_mode mode = GIT_TREEWALK_PRE) const;
 
 	/// @brief Get an entry corresponding to \p path
 	std::optional<TreeEntry> treeEntryByPath(const std::string &path) const noexcept;
 	/// @brief Get an entry on the \p idx-th position
 	TreeEntry treeEntryByIndex(size_t idx) const noexcept;
+	/// @brief Get an entry called \p name directly in this Tree (valid while this Tree lives)
+	std::optional<TreeEntry> treeEntryByName(const std::string &name) const noexcept;
 
 	/// @brief Cat a \p file in this Tree
 	std::optional<std::string> catFile(const std::string &file) const noexcept;
+	/// @brief Cat a \p file in this Tree, without copying its content
+	std::optional<BlobView> catFileView(const std::string &file) const noexcept;
 
 	/// @brief Get the stored pointer to libgit2's git_tree
 	GitTy *tree() const noexcept { return typed(); }
 private:
 	static int walkCB(const char *root, const git_tree_entry *entry, void *payload);
+	template<typename Callback>
+	static int walkCBTyped(const char *root, const git_tree_entry *entry, void *payload);
 
 	friend class Tag;
 	explicit Tree(const Repo &repo, GitTy *tree) noexcept : TypedObject(repo, tree) {}
@@ -71,6 +93,8 @@ public:
 
 	/// @brief Add \p file to this TreeBuilder, having \p blob as a content
 	bool insert(const std::filesystem::path &file, const Blob &blob) const noexcept;
+	/// @brief Add \p dir to this TreeBuilder, having \p tree as a content
+	bool insert(const std::filesystem::path &dir, const Tree &tree) const noexcept;
 	/// @brief Remove \p file from this TreeBuilder
 	bool remove(const std::filesystem::path &file) const noexcept {
 		return !Repo::setLastError(git_treebuilder_remove(treeBuilder(), file.c_str()));
@@ -119,6 +143,8 @@ public:
 
 	/// @brief Get name of this TreeEntry
 	std::string name() const noexcept { return git_tree_entry_name(treeEntry()); }
+	/// @brief Get name of this TreeEntry (as a string_view, no copy)
+	std::string_view nameSV() const noexcept { return git_tree_entry_name(treeEntry()); }
 	/// @brief Get type of this TreeEntry (GIT_OBJECT_TREE, GIT_OBJECT_BLOB, ...)
 	git_object_t type() const noexcept { return git_tree_entry_type(treeEntry()); }
 	/// @brief Get permissions of this TreeEntry
@@ -126,6 +152,8 @@ public:
 
 	/// @brief Cat this TreeEntry
 	std::optional<std::string> catFile(const Repo &repo) const noexcept;
+	/// @brief Cat this TreeEntry, without copying its content
+	std::optional<BlobView> catFileView(const Repo &repo) const noexcept;
 
 	/// @brief Get the stored pointer to libgit2's git_tree_entry
 	GitTy *treeEntry() const noexcept { return m_treeEntry.get(); }
@@ -139,4 +167,22 @@ private:
 	Holder m_treeEntry;
 };
 
+template<typename Callback>
+requires std::is_invocable_r_v<int, Callback &, std::string_view, const TreeEntry &>
+bool Tree::walk(Callback &&CB, git_treewalk_mode mode) const
+{
+	using CallbackTy = std::remove_reference_t<Callback>;
+
+	return !Repo::setLastError(git_tree_walk(tree(), mode, walkCBTyped<CallbackTy>,
+			const_cast<void *>(static_cast<const void *>(std::addressof(CB)))));
+}
+
+template<typename Callback>
+int Tree::walkCBTyped(const char *root, const git_tree_entry *entry, void *payload)
+{
+	auto &CB = *static_cast<Callback *>(payload);
+
+	return CB(std::string_view(root), TreeEntry(entry));
+}
+
 }
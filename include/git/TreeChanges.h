@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <git2.h>
+
+#include "Diff.h"
+
+namespace SlGit {
+
+class Commit;
+class Repo;
+class Tree;
+
+/**
+ * @brief Paths changed between two trees
+ *
+ * This is a cheap alternative to Repo::diff() and Diff::forEach() when only the list of changed
+ * paths is needed: no hunks or lines are generated and binary detection (which loads blobs) is
+ * skipped. Renames are detected only on request.
+ * \code
+ * auto changes = TreeChanges::create(repo, oldCommit, newCommit,
+ *				      { .pathSpec = { "patches.suse/" }, .renames = true });
+ * for (const auto &change : *changes)
+ *	if (change.status == GIT_DELTA_RENAMED)
+ *		rename(change.oldPath, change.newPath);
+ * \endcode
+ */
+class TreeChanges {
+public:
+	/// @brief Options for create()
+	struct Options {
+		/// @brief Consider only paths matching these pathspecs (all paths if empty)
+		std::vector<std::string> pathSpec;
+		/// @brief Detect renames (this reads the blobs of added and deleted files)
+		bool renames = false;
+		/// @brief Similarity (in percent) for rename detection (0 = libgit2's default)
+		uint16_t renameThreshold = 0;
+	};
+
+	/// @brief One changed path
+	struct Change {
+		/// @brief \c GIT_DELTA_ADDED, \c GIT_DELTA_DELETED, \c GIT_DELTA_MODIFIED, ...
+		git_delta_t status;
+		/// @brief The path in the old tree
+		std::string_view oldPath;
+		/// @brief The path in the new tree
+		std::string_view newPath;
+		/// @brief OID of the blob in the old tree (zero if added)
+		git_oid oldId;
+		/// @brief OID of the blob in the new tree (zero if deleted)
+		git_oid newId;
+		/// @brief Similarity of the old and new file (for renames)
+		uint16_t similarity;
+	};
+
+	/**
+	 * @brief Random access iterator over TreeChanges
+	 *
+	 * Changes are created on dereference and returned by value, so this is a C++20
+	 * std::random_access_iterator, but only a legacy input iterator.
+	 */
+	class iterator {
+	public:
+		/// @brief Iterator category (legacy iterators require a reference from operator*)
+		using iterator_category = std::input_iterator_tag;
+		/// @brief Iterator concept
+		using iterator_concept = std::random_access_iterator_tag;
+		/// @brief Value type
+		using value_type = Change;
+		/// @brief Difference type
+		using difference_type = std::ptrdiff_t;
+
+		iterator() : m_changes(nullptr), m_idx(0) {}
+
+		/// @brief Get the current Change
+		Change operator*() const noexcept { return (*m_changes)[m_idx]; }
+		/// @brief Get the Change \p off positions away
+		Change operator[](difference_type off) const noexcept {
+			return (*m_changes)[m_idx + off];
+		}
+
+		/// @brief Move to the next Change
+		iterator &operator++() noexcept { ++m_idx; return *this; }
+		/// @brief Move to the next Change
+		iterator operator++(int) noexcept { auto ret = *this; ++m_idx; return ret; }
+		/// @brief Move to the previous Change
+		iterator &operator--() noexcept { --m_idx; return *this; }
+		/// @brief Move to the previous Change
+		iterator operator--(int) noexcept { auto ret = *this; --m_idx; return ret; }
+		/// @brief Move by \p off
+		iterator &operator+=(difference_type off) noexcept { m_idx += off; return *this; }
+		/// @brief Move by -\p off
+		iterator &operator-=(difference_type off) noexcept { m_idx -= off; return *this; }
+		/// @brief Get an iterator moved by \p off
+		iterator operator+(difference_type off) const noexcept {
+			return iterator(m_changes, m_idx + off);
+		}
+		/// @brief Get an iterator moved by \p off
+		friend iterator operator+(difference_type off, const iterator &it) noexcept {
+			return it + off;
+		}
+		/// @brief Get an iterator moved by -\p off
+		iterator operator-(difference_type off) const noexcept {
+			return iterator(m_changes, m_idx - off);
+		}
+		/// @brief Get the distance between two iterators
+		difference_type operator-(const iterator &other) const noexcept {
+			return static_cast<difference_type>(m_idx) -
+					static_cast<difference_type>(other.m_idx);
+		}
+
+		/// @brief Compare two iterators
+		bool operator==(const iterator &other) const noexcept { return m_idx == other.m_idx; }
+		/// @brief Compare two iterators
+		auto operator<=>(const iterator &other) const noexcept { return m_idx <=> other.m_idx; }
+	private:
+		friend class TreeChanges;
+		iterator(const TreeChanges *changes, size_t idx) : m_changes(changes), m_idx(idx) {}
+
+		const TreeChanges *m_changes;
+		size_t m_idx;
+	};
+
+	TreeChanges() = delete;
+
+	/**
+	 * @brief List paths changed between \p oldTree and \p newTree
+	 * @param repo Repository of the trees
+	 * @param oldTree The old tree (or nullptr for an empty tree)
+	 * @param newTree The new tree (or nullptr for an empty tree)
+	 * @param opts Options, see Options
+	 * @return TreeChanges on success, nullopt otherwise (see Repo::lastError()).
+	 */
+	static std::optional<TreeChanges> create(const Repo &repo, const Tree *oldTree,
+						 const Tree *newTree, const Options &opts) noexcept;
+	/// @brief List paths changed between \p oldTree and \p newTree (default Options)
+	static std::optional<TreeChanges> create(const Repo &repo, const Tree *oldTree,
+						 const Tree *newTree) noexcept {
+		return create(repo, oldTree, newTree, Options());
+	}
+	/**
+	 * @brief List paths changed between \p oldCommit and \p newCommit
+	 * @param repo Repository of the commits
+	 * @param oldCommit The old commit
+	 * @param newCommit The new commit
+	 * @param opts Options, see Options
+	 * @return TreeChanges on success, nullopt otherwise (see Repo::lastError()).
+	 */
+	static std::optional<TreeChanges> create(const Repo &repo, const Commit &oldCommit,
+						 const Commit &newCommit,
+						 const Options &opts) noexcept;
+	/// @brief List paths changed between \p oldCommit and \p newCommit (default Options)
+	static std::optional<TreeChanges> create(const Repo &repo, const Commit &oldCommit,
+						 const Commit &newCommit) noexcept {
+		return create(repo, oldCommit, newCommit, Options());
+	}
+
+	/// @brief Get count of changed paths
+	size_t size() const noexcept { return m_diff.numDeltas(); }
+	/// @brief Test whether nothing changed
+	bool empty() const noexcept { return !size(); }
+
+	/// @brief Get the \p idx-th Change (the paths are valid while this TreeChanges lives)
+	Change operator[](size_t idx) const noexcept;
+
+	/// @brief Get an iterator to the first Change
+	iterator begin() const noexcept { return iterator(this, 0); }
+	/// @brief Get an iterator past the last Change
+	iterator end() const noexcept { return iterator(this, size()); }
+
+	/// @brief Get the underlying Diff (with deltas only)
+	const Diff &diff() const noexcept { return m_diff; }
+private:
+	explicit TreeChanges(Diff &&diff) noexcept : m_diff(std::move(diff)) {}
+
+	Diff m_diff;
+};
+
+}
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <git2.h>
+
+#include "Blob.h"
+#include "Repo.h"
+#include "Tree.h"
+
+namespace SlGit {
+
+/**
+ * @brief Scan blobs of a Tree in parallel
+ *
+ * libgit2 objects cannot be shared among threads, but reading from one repository through
+ * several git_repository instances scales well. So first, enumerate() collects paths, OIDs and
+ * modes of all blobs in a (sub)tree into a flat vector. Then forEachBlob() distributes them to
+ * worker threads, each with its own Repo, and calls a mapping callback on every blob content.
+ * The results are handed over to a merging callback, which is never run concurrently.
+ * \code
+ * TreeScan scan(repo);
+ * if (!scan.enumerate(*commit.tree(), "patches.suse"))
+ *	return false;
+ * scan.forEachBlob([](const Repo &, const TreeScan::Entry &, std::string_view content) {
+ *	return parsePatch(content);
+ * }, [&all](const TreeScan::Entry &entry, PatchInfo &&info) {
+ *	all.emplace(entry.path, std::move(info));
+ * });
+ * \endcode
+ */
+class TreeScan {
+public:
+	/// @brief One blob found by enumerate()
+	struct Entry {
+		/// @brief Path of the blob in the tree
+		std::string path;
+		/// @brief OID of the blob
+		git_oid id;
+		/// @brief Mode of the blob
+		git_filemode_t mode;
+	};
+
+	/// @brief Order in which forEachBlob() merges the results
+	enum struct Order {
+		ORDERED,
+		UNORDERED,
+	};
+
+	/**
+	 * @brief Prepare a scan of trees in \p repo
+	 * @param repo Repository the trees come from (its path is reopened in each thread)
+	 * @param threads Count of threads to use (0 = count of CPUs)
+	 */
+	TreeScan(const Repo &repo, unsigned threads = 0) : m_repoPath(repo.path()),
+		m_threads(threads ? : std::max(std::thread::hardware_concurrency(), 1U)) {}
+
+	/**
+	 * @brief Collect all blobs in \p tree (or in its \p subdir)
+	 * @param tree Tree to walk
+	 * @param subdir Subdirectory of \p tree to walk instead (or empty string)
+	 * @return true on success, see lastError() otherwise.
+	 *
+	 * The paths are relative to \p tree, i.e. they start with \p subdir. The collected
+	 * entries are appended to entries().
+	 */
+	bool enumerate(const Tree &tree, const std::string &subdir = "");
+
+	/**
+	 * @brief Call \p map on every blob from entries() in parallel, pass results to \p merge
+	 * @param map Callable as R(const Repo &repo, const Entry &entry, std::string_view content),
+	 * run in worker threads
+	 * @param merge Callable as void(const Entry &entry, R &&result), never run concurrently
+	 * @param order Order::ORDERED to \p merge in the order of entries(), Order::UNORDERED to
+	 * \p merge as soon as the result is available
+	 * @return true on success, see lastError() otherwise.
+	 *
+	 * \p content is valid only during the \p map call. An exception thrown from \p map or
+	 * \p merge stops the scan and its what() is stored as lastError().
+	 */
+	template<typename Map, typename Merge>
+	requires std::is_invocable_v<Map &, const Repo &, const Entry &, std::string_view>
+	bool forEachBlob(Map &&map, Merge &&merge, Order order = Order::ORDERED);
+
+	/// @brief Get the entries collected by enumerate()
+	const std::vector<Entry> &entries() const noexcept { return m_entries; }
+	/// @brief Drop the entries collected by enumerate()
+	void clear() noexcept { m_entries.clear(); }
+
+	/// @brief Return the last error string if some
+	const std::string &lastError() const noexcept { return m_lastError; }
+private:
+	void setError(std::string &&error) {
+		std::lock_guard lock(m_lock);
+		if (m_lastError.empty())
+			m_lastError = std::move(error);
+		m_stop = true;
+	}
+
+	template<typename R, typename Map, typename Merge>
+	void worker(Map &map, Merge &merge, Order order, std::vector<std::optional<R>> &pending,
+		    size_t &nextMerge);
+
+	const std::filesystem::path m_repoPath;
+	const unsigned m_threads;
+	std::vector<Entry> m_entries;
+
+	std::mutex m_lock;
+	std::atomic<size_t> m_next;
+	std::atomic<bool> m_stop;
+	std::string m_lastError;
+};
+
+template<typename Map, typename Merge>
+requires std::is_invocable_v<Map &, const Repo &, const TreeScan::Entry &, std::string_view>
+bool TreeScan::forEachBlob(Map &&map, Merge &&merge, Order order)
+{
+	using R = std::invoke_result_t<Map &, const Repo &, const Entry &, std::string_view>;
+
+	m_lastError.clear();
+	m_next = 0;
+	m_stop = false;
+
+	std::vector<std::optional<R>> pending;
+	if (order == Order::ORDERED)
+		pending.resize(m_entries.size());
+	size_t nextMerge = 0;
+
+	std::vector<std::thread> threads;
+	const auto count = std::min<size_t>(m_threads, m_entries.size());
+	for (auto i = 0U; i < count; ++i)
+		threads.emplace_back([this, &map, &merge, order, &pending, &nextMerge]() {
+			worker<R>(map, merge, order, pending, nextMerge);
+		});
+	for (auto &t : threads)
+		t.join();
+
+	return !m_stop;
+}
+
+template<typename R, typename Map, typename Merge>
+void TreeScan::worker(Map &map, Merge &merge, Order order, std::vector<std::optional<R>> &pending,
+		      size_t &nextMerge)
+{
+	const auto repo = Repo::open(m_repoPath);
+	if (!repo) {
+		setError("cannot open " + m_repoPath.string() + ": " + Repo::lastError());
+		return;
+	}
+
+	try {
+		while (!m_stop) {
+			const auto idx = m_next++;
+			if (idx >= m_entries.size())
+				break;
+
+			const auto &entry = m_entries[idx];
+			const auto blob = repo->blobLookup(entry.id);
+			if (!blob) {
+				setError("cannot read " + entry.path + ": " + Repo::lastError());
+				break;
+			}
+
+			auto res = map(*repo, entry, blob->contentView());
+
+			std::lock_guard lock(m_lock);
+			if (m_stop)
+				break;
+			if (order == Order::UNORDERED) {
+				merge(entry, std::move(res));
+				continue;
+			}
+			pending[idx].emplace(std::move(res));
+			for (; nextMerge < pending.size() && pending[nextMerge]; ++nextMerge) {
+				merge(m_entries[nextMerge], std::move(*pending[nextMerge]));
+				pending[nextMerge].reset();
+			}
+		}
+	} catch (const std::exception &e) {
+		setError(e.what());
+	}
+}
+
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "MetricsFetchCallbacks.h"
+
+namespace SlGit {
+
+/**
+ * @brief Fetch remotes of several repositories concurrently
+ *
+ * This is Repo::update() for many (repository, remote) pairs at once. Each pair is fetched in a
+ * worker thread with its own Repo and FetchCallbacks. Instead of the per-fetch output of
+ * DefaultFetchCallbacks, a single line summing up the progress of all the fetches is printed
+ * periodically. The result of every fetch is returned as a Result.
+ * \code
+ * Updater updater;
+ * updater.add(linuxPath);
+ * updater.add(kernelSourcePath);
+ * updater.add(vulnsPath, "upstream");
+ * const auto results = updater.run();
+ * Updater::report(std::cerr, results);
+ * \endcode
+ */
+class Updater {
+public:
+	/// @brief Result of one fetch
+	struct Result {
+		/// @brief Path to the repository
+		std::filesystem::path path;
+		/// @brief Name of the fetched remote
+		std::string remote;
+		/// @brief Did the fetch succeed?
+		bool ok;
+		/// @brief Error message if not \p ok
+		std::string error;
+		/// @brief Count of objects the remote sent
+		size_t totalObjects;
+		/// @brief Count of objects received
+		size_t receivedObjects;
+		/// @brief Count of objects found locally (in a thin pack)
+		size_t localObjects;
+		/// @brief Count of bytes received
+		size_t receivedBytes;
+		/// @brief Count of updated references
+		size_t updatedRefs;
+		/// @brief How long the fetch took
+		std::chrono::milliseconds duration;
+		/// @brief Phases and throughput of the transfer
+		MetricsFetchCallbacks::Summary metrics;
+	};
+
+	/// @brief Prepare an Updater running up to \p threads fetches at once (0 = all at once)
+	Updater(unsigned int threads = 0) : m_threads(threads) {}
+
+	/// @brief Queue fetching of \p remote in the repository at \p path
+	void add(const std::filesystem::path &path, const std::string &remote = "origin") {
+		m_jobs.push_back({ path, remote });
+	}
+
+	/// @brief Get count of the queued fetches
+	size_t size() const noexcept { return m_jobs.size(); }
+
+	/**
+	 * @brief Run all the queued fetches
+	 * @param progress Print the summed progress to std::cerr
+	 * @return Result for every add(), in the same order.
+	 */
+	std::vector<Result> run(bool progress = true);
+
+	/// @brief Print one line per Result in \p results and their totals to \p os
+	static void report(std::ostream &os, const std::vector<Result> &results);
+private:
+	struct Job {
+		std::filesystem::path path;
+		std::string remote;
+	};
+
+	static void fetch(Result &result, std::mutex &lock);
+	static void printProgress(const std::vector<Result> &results, size_t done);
+
+	const unsigned int m_threads;
+	std::vector<Job> m_jobs;
+};
+
+}
@@ -74,7 +74,7 @@ private:
 	bool consumeParens(std::string_view ref, const char *&parenStart,
 			   const std::vector<std::string> &patchEmails);
 
-	int processPatch(const std::filesystem::path &file, const std::string &content);
+	int processPatch(const std::filesystem::path &file, std::string_view content);
 
 	const SlGit::Repo *repo;
 	const bool dumpRefs;
@@ -42,7 +42,7 @@ public:
 
 	/// @brief Create a new RPMConfig from the \p tree
 	static std::optional<RPMConfig> create(const SlGit::Tree &tree) noexcept {
-		if (const auto config = tree.catFile("rpm/config.sh"))
+		if (const auto config = tree.catFileView("rpm/config.sh"))
 			return RPMConfig(*config);
 
 		return std::nullopt;
@@ -51,7 +51,7 @@ public:
 	/// @brief Create a new RPMConfig from the \p branch in the \p repo
 	static std::optional<RPMConfig> create(const SlGit::Repo &repo,
 					       const std::string &branch) noexcept {
-		if (const auto config = repo.catFile("origin/" + branch, "rpm/config.sh"))
+		if (const auto config = repo.catFileView("origin/" + branch, "rpm/config.sh"))
 			return RPMConfig(*config);
 
 		return std::nullopt;
@@ -2,9 +2,18 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -23,6 +32,10 @@ enum class OpenFlags : unsigned {
 	NO_FOREIGN_KEY			= 1 << 1,
 	ERROR_ON_UNIQUE_CONSTRAINT	= 1 << 2,
 	READ_ONLY			= 1 << 3,
+	BULK_LOAD			= 1 << 4,
+	SHARED_CACHE			= 1 << 5,
+	URI				= 1 << 6,
+	MEMORY				= 1 << 7,
 };
 
 } // namespace
@@ -40,6 +53,47 @@ enum struct TransactionType {
 	EXCLUSIVE,
 };
 
+/**
+ * @brief Checkpoint modes used for SQLConn::checkpoint()
+ */
+enum struct CheckpointMode {
+	PASSIVE,
+	FULL,
+	RESTART,
+	TRUNCATE,
+};
+
+/**
+ * @brief How SQLConn waits for a locked database
+ *
+ * The n-th wait sleeps \c initialDelay*2^n (capped at \c maxDelay). SQLITE_BUSY is returned
+ * once the lock was not obtained within \c deadline.
+ */
+struct BusyPolicy {
+	/// @brief The first sleep
+	std::chrono::microseconds initialDelay { 100 };
+	/// @brief Maximal sleep
+	std::chrono::microseconds maxDelay { 20000 };
+	/// @brief Give up after waiting this long
+	std::chrono::milliseconds deadline { 10000 };
+};
+
+/**
+ * @brief Statistics of waiting for locks, see SQLConn::busyStats()
+ */
+struct BusyStats {
+	/// @brief How many times a lock was waited for
+	uint64_t waits = 0;
+	/// @brief How many sleeps were needed in total
+	uint64_t sleeps = 0;
+	/// @brief How many times the waiting timed out
+	uint64_t timeouts = 0;
+	/// @brief Total time slept
+	std::chrono::microseconds waited {};
+	/// @brief The longest wait for one lock
+	std::chrono::microseconds maxWait {};
+};
+
 class Select;
 class SQLConn;
 
@@ -74,6 +128,8 @@ public:
 
 	/// @brief End the transaction manually
 	void end();
+	/// @brief Roll the transaction back
+	void rollback();
 
 	/// @brief Test whether AutoTransaction is valid
 	bool operator!() const { return !m_conn; }
@@ -96,6 +152,45 @@ public:
 	/// @brief Move assignment
 	SQLConn &operator=(SQLConn &&) = default;
 
+	/**
+	 * @brief Called by backupTo() and restoreFrom() after every step
+	 *
+	 * Gets the count of pages still to be copied and the total count of pages. Return false
+	 * to abort the copy.
+	 */
+	using BackupProgress = std::function<bool (int remaining, int total)>;
+
+	/// @brief Statistics of one statement collected by enableProfiling()
+	struct StmtProfile {
+		/// @brief The SQL of the statement
+		std::string sql;
+		/// @brief How many times it was run
+		uint64_t calls = 0;
+		/// @brief Total time spent running the statement
+		std::chrono::nanoseconds total {};
+		/// @brief The longest run
+		std::chrono::nanoseconds max {};
+		/// @brief Virtual machine steps
+		uint64_t vmSteps = 0;
+		/// @brief Steps in full table scans (a missing index)
+		uint64_t fullScanSteps = 0;
+		/// @brief Sort operations (a missing index)
+		uint64_t sorts = 0;
+		/// @brief Rows inserted into automatic indices (a missing index)
+		uint64_t autoIndexRows = 0;
+		/// @brief Runs taking at least the slow threshold of enableProfiling()
+		uint64_t slowCalls = 0;
+	};
+
+	/// @brief Aggregated result of insertBatch()
+	struct BatchResult {
+		/// @brief Count of inserted rows
+		uint64_t affected = 0;
+		/// @brief Count of rows not inserted due to a unique constraint (always 0 when the
+		/// tail is "ON CONFLICT DO NOTHING" -- such rows are skipped silently)
+		uint64_t uniqueConflicts = 0;
+	};
+
 	/**
 	 * @brief Open a database connection (openDB() + createDB() + prepDB())
 	 * @param dbFile Path to the database
@@ -112,6 +207,10 @@ public:
 	 * @param dbFile Path to the database
 	 * @param flags Flags to use (like OpenFlags::CREATE)
 	 * @return true on success.
+	 *
+	 * Pass ":memory:" as \p dbFile for a private in-memory DB. With OpenFlags::URI,
+	 * "file::memory:?cache=shared" is an in-memory DB shared by the connections of this
+	 * process. See backupTo() to persist such a DB.
 	 */
 	bool openDB(const std::filesystem::path &dbFile,
 		    OpenFlags flags = OpenFlags::NONE) noexcept;
@@ -161,6 +260,94 @@ public:
 	 */
 	bool end() const noexcept { return exec("END;", "db END failed"); }
 
+	/**
+	 * @brief Roll a transaction back
+	 * @return true on success.
+	 */
+	bool rollback() const noexcept { return exec("ROLLBACK;", "db ROLLBACK failed"); }
+
+	/**
+	 * @brief Start a savepoint called \p name
+	 * @return true on success.
+	 */
+	bool savepoint(const std::string &name) const noexcept {
+		return exec("SAVEPOINT " + name + ";", "db SAVEPOINT failed");
+	}
+
+	/**
+	 * @brief Release the savepoint \p name (and the later ones)
+	 * @return true on success.
+	 */
+	bool release(const std::string &name) const noexcept {
+		return exec("RELEASE " + name + ";", "db RELEASE failed");
+	}
+
+	/**
+	 * @brief Roll back to the savepoint \p name (it stays active, release() it)
+	 * @return true on success.
+	 */
+	bool rollbackTo(const std::string &name) const noexcept {
+		return exec("ROLLBACK TO " + name + ";", "db ROLLBACK TO failed");
+	}
+
+	/**
+	 * @brief Copy the whole DB to \p dbFile (overwriting it) using the online backup API
+	 * @param dbFile Path to the destination database
+	 * @param progress Callback to invoke after every step (or empty)
+	 * @param pagesPerStep How many pages to copy in one step
+	 * @return true on success.
+	 *
+	 * Locked steps are retried until BusyPolicy::deadline (see setBusyPolicy()) passes
+	 * without a successful step. Then the copy fails with SQLITE_BUSY (or SQLITE_LOCKED) in
+	 * lastErrorCode().
+	 */
+	bool backupTo(const std::filesystem::path &dbFile, const BackupProgress &progress = {},
+		      int pagesPerStep = 1024) const noexcept;
+
+	/**
+	 * @brief Replace the content of this DB by the one of \p dbFile
+	 * @param dbFile Path to the source database
+	 * @param progress Callback to invoke after every step (or empty)
+	 * @param pagesPerStep How many pages to copy in one step
+	 * @return true on success.
+	 *
+	 * Prepared statements stay valid as SQLite re-prepares them on the schema change. Locked
+	 * steps are retried as in backupTo().
+	 */
+	bool restoreFrom(const std::filesystem::path &dbFile, const BackupProgress &progress = {},
+			 int pagesPerStep = 1024) noexcept;
+
+	/**
+	 * @brief Set how to wait for a locked database
+	 * @param policy The policy to use
+	 */
+	void setBusyPolicy(const BusyPolicy &policy) noexcept { busy().policy = policy; }
+	/// @brief Return statistics of waiting for locks
+	const BusyStats &busyStats() const noexcept {
+		static const BusyStats none{};
+		return m_busy ? m_busy->stats : none;
+	}
+
+	/**
+	 * @brief Set after how many WAL pages a checkpoint is run automatically
+	 * @param pages Count of pages (0 or negative to disable automatic checkpoints)
+	 * @return true on success.
+	 */
+	bool setAutoCheckpoint(int pages) const noexcept;
+
+	/**
+	 * @brief Run a WAL checkpoint
+	 * @param mode Kind of checkpoint
+	 * @param logFrames Where to store the count of frames in the WAL (or nullptr)
+	 * @param checkpointed Where to store the count of frames written to the DB (or nullptr)
+	 * @return true on success.
+	 */
+	bool checkpoint(CheckpointMode mode = CheckpointMode::PASSIVE, int *logFrames = nullptr,
+			int *checkpointed = nullptr) const noexcept;
+
+	/// @brief Test whether a transaction is in progress
+	bool inTransaction() const noexcept;
+
 	/**
 	 * @brief Begin a transaction which is automatically ended when the returned object dies
 	 * @param type Kind of transaction
@@ -170,6 +357,47 @@ public:
 		return AutoTransaction(*this, type);
 	}
 
+	/**
+	 * @brief Start a bulk-load session
+	 * @return true on success.
+	 *
+	 * Switches the DB to WAL, turns off syncing, enlarges the page cache, and keeps
+	 * temporaries in memory. createIndices() and createTriggers() only record what to
+	 * create until endBulkLoad(), so that the loaded rows do not pay for index maintenance
+	 * (and do not fire the triggers). This is called by openDB() for OpenFlags::BULK_LOAD,
+	 * so that the indices from createDB() are deferred too. Calling this in a session does
+	 * nothing.
+	 */
+	bool beginBulkLoad() noexcept;
+
+	/**
+	 * @brief End a bulk-load session
+	 * @return true on success.
+	 *
+	 * Creates the deferred indices and triggers and restores the journal mode, syncing, cache
+	 * size, and temporary store as they were before beginBulkLoad(). All of this is attempted
+	 * even if some step fails (the failure is reported by the return value then).
+	 */
+	bool endBulkLoad() noexcept;
+
+	/**
+	 * @brief Start collecting statistics of statements
+	 * @param slowThreshold Log statements running at least this long to std::cerr (0 = off)
+	 * @return true on success.
+	 *
+	 * Uses SQLITE_TRACE_PROFILE and sqlite3_stmt_status(), see profile(). SQLite measures
+	 * the time using the VFS clock, which has only millisecond granularity on common VFSes
+	 * (unix included). So short statements are reported as taking 0, and the times are
+	 * meaningful only when summed over many calls or for long statements.
+	 */
+	bool enableProfiling(std::chrono::milliseconds slowThreshold = {}) noexcept;
+	/// @brief Stop collecting statistics (the collected ones are kept)
+	void disableProfiling() noexcept;
+	/// @brief Return the statistics collected so far, the most expensive first
+	std::vector<StmtProfile> profile() const;
+	/// @brief Dump profile() to \p os
+	void dumpProfile(std::ostream &os) const;
+
 	/// @brief Return the last error string if some
 	std::string lastError() const { return m_lastError.lastError(); }
 	/// @brief Return the last error number
@@ -178,14 +406,23 @@ public:
 	int lastErrorCodeExt() const { return m_lastError.get<1>(); }
 
 protected:
-	SQLConn() : m_flags(OpenFlags::NONE) {}
-
-	/// @brief Bind value (SQL's null, number, string)
-	using BindVal = std::variant<std::monostate, int, unsigned, std::string, std::string_view>;
+	SQLConn() : m_flags(OpenFlags::NONE), m_bulkLoad(false),
+		m_busy(std::make_unique<Busy>()) {}
+
+	/// @brief Binary data to bind
+	using Blob = std::span<const std::byte>;
+	/// @brief Bind value (SQL's null, number, string, blob)
+	using BindVal = std::variant<std::monostate, int, unsigned, std::string, std::string_view,
+				     int64_t, double, Blob>;
 	/// @brief Bind name -> bind value
 	using Binding = std::vector<std::pair<std::string, BindVal>>;
-	/// @brief One column returned by SELECT
-	using Column = std::variant<std::monostate, int, std::string>;
+	/**
+	 * @brief One column returned by SELECT
+	 *
+	 * Integers are returned as int if they fit, as int64_t otherwise.
+	 */
+	using Column = std::variant<std::monostate, int, std::string, int64_t, double,
+				    std::vector<std::byte>>;
 	/// @brief One row returned by SELECT (ie. list of Columns)
 	using Row = std::vector<Column>;
 	/// @brief Complete SELECT result
@@ -248,6 +485,135 @@ protected:
 	std::optional<SQLConn::SelectResult>
 	select(const SQLStmtHolder &sel, const Binding &binding) const noexcept;
 
+	/// @brief Bind \p vals to the statement \p ins positionally
+	template <typename... Args>
+	bool bind(const TypedStmtHolder<Args...> &ins,
+		  const typename TypedStmtHolder<Args...>::Values &vals) const noexcept {
+		return checkParamCount(ins, sizeof...(Args)) && bindTuple(ins, 0, vals);
+	}
+	/// @brief Bind, step, and reset the statement \p ins, using the passed \p vals
+	template <typename... Args>
+	bool insert(const TypedStmtHolder<Args...> &ins,
+		    const typename TypedStmtHolder<Args...>::Values &vals,
+		    uint64_t *affected = nullptr) const noexcept {
+		SQLStmtResetter insResetter(ins);
+		return bind(ins, vals) && stepAndReset(ins, insResetter, affected);
+	}
+	/**
+	 * @brief Insert all \p rows using multi-row INSERT statements in one transaction
+	 * @param insert The INSERT statement up to VALUES, e.g. "INSERT INTO tab(a, b)"
+	 * @param rows A range of tuples (as in TypedStmtHolder), one tuple per row; the tuples
+	 * are bound without copying, so the range must yield references to tuples living
+	 * during the call (not temporaries like views::transform does)
+	 * @param result Where to store the count of inserted and conflicting rows (or nullptr)
+	 * @param tail Appended after the VALUES list, e.g. "ON CONFLICT DO NOTHING"
+	 * @return true on success.
+	 *
+	 * As many rows are inserted by one statement as SQLite's variable limit allows, the
+	 * remaining rows by one more statement prepared for their count. If a statement hits a
+	 * unique constraint, its rows are inserted one by one, so that the conflicting rows are
+	 * handled as in insert(). The transaction is not started if one is already in progress.
+	 * If this function started the transaction, it is rolled back on failure, so that no rows
+	 * are inserted.
+	 */
+	template <std::ranges::forward_range Range>
+	requires std::is_lvalue_reference_v<std::ranges::range_reference_t<const Range>>
+	bool insertBatch(std::string_view insert, const Range &rows, BatchResult *result = nullptr,
+			 std::string_view tail = {}) const noexcept {
+		constexpr int cols = std::tuple_size_v<std::ranges::range_value_t<Range>>;
+		const auto perStmt = batchRows(cols);
+		SQLStmtHolder multi, rest, single;
+		if (!prepareStatement(batchSQL(insert, cols, perStmt, tail), multi) ||
+				!prepareStatement(batchSQL(insert, cols, 1, tail), single))
+			return false;
+
+		std::optional<AutoTransaction> trans;
+		if (!inTransaction() && !trans.emplace(*this, TransactionType::IMMEDIATE))
+			return false;
+
+		BatchResult res;
+		const auto insertSingle = [this, &single, &res](auto first, auto last) {
+			for (; first != last; ++first) {
+				SQLStmtResetter singleResetter(single);
+				uint64_t affected;
+				bool uniqueError;
+				if (!bindTuple(single, 0, *first) ||
+						!step(single, &affected, &uniqueError))
+					return false;
+				res.affected += affected;
+				res.uniqueConflicts += uniqueError;
+			}
+			return true;
+		};
+
+		const auto insertMulti = [this, cols, &res, &insertSingle](
+				const SQLStmtHolder &stmt, auto first, auto last) {
+			uint64_t affected;
+			bool uniqueError;
+			{
+				SQLStmtResetter stmtResetter(stmt);
+				auto offset = 0;
+				for (auto it = first; it != last; ++it, offset += cols)
+					if (!bindTuple(stmt, offset, *it))
+						return false;
+				if (!step(stmt, &affected, &uniqueError) && !uniqueError)
+					return false;
+			}
+
+			if (uniqueError)
+				return insertSingle(first, last);
+			res.affected += affected;
+			return true;
+		};
+
+		const auto insertAll = [this, insert, tail, &rows, cols, perStmt, &multi, &rest,
+				&insertSingle, &insertMulti]() {
+			const auto end = std::ranges::end(rows);
+			for (auto first = std::ranges::begin(rows); first != end; ) {
+				auto last = first;
+				auto count = 0U;
+				for (; count < perStmt && last != end; ++count)
+					++last;
+
+				if (count == perStmt) {
+					if (!insertMulti(multi, first, last))
+						return false;
+				} else if (count == 1) {
+					return insertSingle(first, last);
+				} else {
+					/* only the last chunk is shorter */
+					const auto sql = batchSQL(insert, cols, count, tail);
+					return prepareStatement(sql, rest) &&
+						insertMulti(rest, first, last);
+				}
+				first = last;
+			}
+
+			return true;
+		};
+
+		if (!insertAll()) {
+			if (trans)
+				trans->rollback();
+			return false;
+		}
+
+		if (result)
+			*result = res;
+
+		return true;
+	}
+
+	/// @brief Perform one SELECT (\p sel), using the passed \p vals
+	template <typename... Args>
+	std::optional<SQLConn::SelectResult>
+	select(const TypedStmtHolder<Args...> &sel,
+	       const typename TypedStmtHolder<Args...>::Values &vals) const noexcept {
+		if (!bind(sel, vals))
+			return std::nullopt;
+		return select(sel, Binding{});
+	}
+
 	/// @brief A helper to build a null BindVal if \p cond does not hold, \p val otherwise
 	static BindVal valueOrNull(bool cond, BindVal val) {
 		return cond ? std::move(val) : std::monostate();
@@ -263,15 +629,77 @@ protected:
 	SQLHolder sqlHolder;
 	/// @brief OpenFlags
 	OpenFlags m_flags;
+	/// @brief In a bulk-load session (see beginBulkLoad())
+	bool m_bulkLoad;
+	/// @brief Indices deferred by the bulk-load session
+	mutable Indices m_deferredIndices;
+	/// @brief Triggers deferred by the bulk-load session
+	mutable Triggers m_deferredTriggers;
+	/// @brief PRAGMAs restoring the settings changed by beginBulkLoad()
+	std::string m_bulkRestore;
 	/// @brief The last error + error code + extended error code
 	mutable LastError m_lastError;
 private:
+	struct Busy {
+		BusyPolicy policy;
+		BusyStats stats;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	struct Profiler {
+		std::chrono::nanoseconds slowThreshold;
+		std::unordered_map<std::string, StmtProfile> stmts;
+	};
+
 	bool exec(const std::string &SQL, std::string_view errorMsg,
 		  bool includeSQL = false) const noexcept;
 
 	static constexpr bool isUniqueConstraint(int sqlExtError) noexcept;
-	static int busyHandler(void *, int count);
+	std::optional<std::string> pragma(std::string_view name) const noexcept;
+	static int busyHandler(void *ctx, int count);
+	Busy &busy() noexcept {
+		if (!m_busy)
+			m_busy = std::make_unique<Busy>();
+		return *m_busy;
+	}
+	static int traceProfile(unsigned type, void *ctx, void *P, void *X);
+	bool backup(sqlite3 *dest, sqlite3 *src, const BackupProgress &progress,
+		    int pagesPerStep) const noexcept;
 	void dumpBinding(const Binding &binding) const noexcept;
+
+	bool checkParamCount(const SQLStmtHolder &stmt, int count) const noexcept;
+	template <typename Tuple>
+	bool bindTuple(const SQLStmtHolder &stmt, int offset, const Tuple &vals) const noexcept {
+		return std::apply([this, &stmt, offset](const auto &... val) {
+			auto idx = offset;
+			return (bindOne(stmt, ++idx, val) && ...);
+		}, vals);
+	}
+	bool bindOne(const SQLStmtHolder &stmt, int idx, std::monostate) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, int val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, unsigned val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, int64_t val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, double val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, std::string_view val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, Blob val) const noexcept;
+	bool bindOne(const SQLStmtHolder &stmt, int idx, const std::string &val) const noexcept {
+		return bindOne(stmt, idx, std::string_view(val));
+	}
+	template <typename T>
+	bool bindOne(const SQLStmtHolder &stmt, int idx, const std::optional<T> &val) const noexcept {
+		return val ? bindOne(stmt, idx, *val) : bindOne(stmt, idx, std::monostate());
+	}
+	static int bindBlob(const SQLStmtHolder &stmt, int idx, Blob blob, void (*flag)(void *));
+	bool bindError(const SQLStmtHolder &stmt, int idx, int ret,
+		       std::string_view val) const noexcept;
+	bool stepAndReset(const SQLStmtHolder &ins, SQLStmtResetter &insResetter,
+			  uint64_t *affected) const noexcept;
+	unsigned batchRows(int cols) const noexcept;
+	static std::string batchSQL(std::string_view insert, int cols, unsigned rows,
+				    std::string_view tail);
+
+	std::unique_ptr<Busy> m_busy;
+	std::unique_ptr<Profiler> m_profiler;
 };
 
 inline AutoTransaction::AutoTransaction(const SQLConn &conn, TransactionType type)
@@ -287,4 +715,12 @@ inline void AutoTransaction::end()
 	}
 }
 
+inline void AutoTransaction::rollback()
+{
+	if (m_conn) {
+		m_conn->rollback();
+		m_conn = nullptr;
+	}
+}
+
 }
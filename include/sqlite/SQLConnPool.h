@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "SQLConn.h"
+
+namespace SlSqlite {
+
+/**
+ * @brief A pool of read-only connections to one database
+ *
+ * Every connection is a separate \p Conn, opened by Conn::open(), so the statements of
+ * \p Conn are prepared on each of them. The connections are handed out as Lease, one thread at
+ * a time. Writes should go through a separate (read-write) connection. Put the database into
+ * WAL (e.g. by SQLConn::beginBulkLoad()) from the writer, so that the readers do not block it.
+ * \code
+ * SQLConnPool<MyDB> pool;
+ * if (!pool.open(dbFile, std::thread::hardware_concurrency()))
+ *	return false;
+ * // in some thread
+ * auto conn = pool.get();
+ * if (!conn)
+ *	return false;
+ * auto res = (*conn)->getSomething();
+ * \endcode
+ */
+template <typename Conn> requires std::derived_from<Conn, SQLConn>
+class SQLConnPool {
+public:
+	/**
+	 * @brief A connection borrowed from SQLConnPool, returned back when destroyed
+	 */
+	class Lease {
+	public:
+		~Lease() { release(); }
+
+		Lease(const Lease &) = delete;
+		Lease &operator=(const Lease &) = delete;
+
+		/// @brief Move constructor
+		Lease(Lease &&other) noexcept : m_pool(other.m_pool), m_conn(other.m_conn) {
+			other.m_conn = nullptr;
+		}
+		/// @brief Move assignment
+		Lease &operator=(Lease &&other) noexcept {
+			if (this != &other) {
+				release();
+				m_pool = other.m_pool;
+				m_conn = other.m_conn;
+				other.m_conn = nullptr;
+			}
+
+			return *this;
+		}
+
+		/// @brief Access the connection
+		Conn *operator->() const { return m_conn; }
+		/// @brief Access the connection
+		Conn &operator*() const { return *m_conn; }
+	private:
+		friend class SQLConnPool;
+		Lease(SQLConnPool *pool, Conn *conn) : m_pool(pool), m_conn(conn) {}
+
+		void release() {
+			if (m_conn) {
+				m_pool->put(m_conn);
+				m_conn = nullptr;
+			}
+		}
+
+		SQLConnPool *m_pool;
+		Conn *m_conn;
+	};
+
+	SQLConnPool() {}
+
+	SQLConnPool(const SQLConnPool &) = delete;
+	SQLConnPool &operator=(const SQLConnPool &) = delete;
+
+	/**
+	 * @brief Open \p count connections to \p dbFile
+	 * @param dbFile Path to the database
+	 * @param count Count of connections to open
+	 * @param flags Flags to use, OpenFlags::READ_ONLY is added implicitly. Consider
+	 * OpenFlags::SHARED_CACHE to share pages among the connections.
+	 * @return true on success.
+	 *
+	 * Do not call this while some Lease is alive.
+	 */
+	bool open(const std::filesystem::path &dbFile, unsigned count,
+		  OpenFlags flags = OpenFlags::NONE) {
+		std::lock_guard lock(m_lock);
+
+		m_free.clear();
+		m_conns.clear();
+		for (auto i = 0U; i < std::max(count, 1U); ++i) {
+			auto conn = std::make_unique<Conn>();
+			if (!conn->open(dbFile, flags | OpenFlags::READ_ONLY)) {
+				m_lastError = conn->lastError();
+				m_free.clear();
+				m_conns.clear();
+				return false;
+			}
+			m_free.push_back(conn.get());
+			m_conns.push_back(std::move(conn));
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Borrow a connection, wait for one if all are in use
+	 * @return Lease holding the connection, or nullopt if the pool has no connections (open()
+	 * was not called or failed).
+	 */
+	std::optional<Lease> get() {
+		std::unique_lock lock(m_lock);
+		if (m_conns.empty())
+			return std::nullopt;
+		m_cond.wait(lock, [this] { return !m_free.empty(); });
+
+		return take();
+	}
+
+	/**
+	 * @brief Borrow a connection if some is available
+	 * @return Lease holding the connection or nullopt.
+	 */
+	std::optional<Lease> tryGet() {
+		std::lock_guard lock(m_lock);
+		if (m_free.empty())
+			return std::nullopt;
+
+		return take();
+	}
+
+	/// @brief Return the count of connections
+	size_t size() const { return m_conns.size(); }
+
+	/// @brief Return the last error string if some (from open())
+	const std::string &lastError() const { return m_lastError; }
+private:
+	Lease take() {
+		auto conn = m_free.back();
+		m_free.pop_back();
+		return Lease(this, conn);
+	}
+
+	void put(Conn *conn) {
+		{
+			std::lock_guard lock(m_lock);
+			m_free.push_back(conn);
+		}
+		m_cond.notify_one();
+	}
+
+	std::mutex m_lock;
+	std::condition_variable m_cond;
+	std::vector<std::unique_ptr<Conn>> m_conns;
+	std::vector<Conn *> m_free;
+	std::string m_lastError;
+};
+
+}
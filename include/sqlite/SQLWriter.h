@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SQLConn.h"
+
+namespace SlSqlite {
+
+/**
+ * @brief Performs writes to one connection from a dedicated thread
+ *
+ * Producers push() jobs (usually calling some insert method of \p Conn) from any thread without
+ * waiting for SQLite. The writer thread runs them in transactions, committing after
+ * \p commitRows jobs, after \p commitInterval, or when flush() is called. The connection must
+ * not be used by anybody else while SQLWriter lives.
+ *
+ * Every job runs in its own savepoint, so that the writes of a failed job are rolled back, while
+ * the other jobs of the transaction are committed. If the transaction cannot be begun, the jobs
+ * meant for it run in autocommit mode, i.e. every statement is committed on its own (and a
+ * failed job's earlier writes stay).
+ * \code
+ * SQLWriter<MyDB> writer(db);
+ * for (const auto &e : entries)
+ *	writer.push([e](const MyDB &db) { return db.insertEntry(e.name, e.value); });
+ * if (!writer.flush())
+ *	std::cerr << writer.lastError() << '\n';
+ * \endcode
+ */
+template <typename Conn> requires std::derived_from<Conn, SQLConn>
+class SQLWriter {
+public:
+	/// @brief One job to run in the writer thread, return false on failure
+	using Job = std::function<bool (const Conn &conn)>;
+
+	/**
+	 * @brief Start the writer thread for \p conn
+	 * @param conn Connection to write to
+	 * @param commitRows Commit after this many jobs
+	 * @param commitInterval Commit at latest after this time
+	 * @param maxQueued push() waits when this many jobs are queued
+	 */
+	SQLWriter(const Conn &conn, unsigned commitRows = 10000,
+		  std::chrono::milliseconds commitInterval = std::chrono::milliseconds(200),
+		  size_t maxQueued = 100000) :
+		m_conn(conn), m_commitRows(std::max(commitRows, 1U)),
+		m_commitInterval(std::max(commitInterval, std::chrono::milliseconds(1))),
+		m_maxQueued(std::max<size_t>(maxQueued, 1)),
+		m_pushed(0), m_done(0), m_flushing(0), m_stop(false), m_failed(false),
+		m_thread(&SQLWriter::run, this) {}
+
+	/// @brief Run the remaining jobs and stop the writer thread
+	~SQLWriter() {
+		{
+			std::lock_guard lock(m_lock);
+			m_stop = true;
+		}
+		m_cond.notify_one();
+		m_thread.join();
+	}
+
+	SQLWriter(const SQLWriter &) = delete;
+	SQLWriter &operator=(const SQLWriter &) = delete;
+
+	/**
+	 * @brief Queue \p job, wait if the queue is full
+	 * @param job The job to run in the writer thread
+	 */
+	void push(Job job) {
+		std::unique_lock lock(m_lock);
+		m_spaceCond.wait(lock, [this] { return m_queue.size() < m_maxQueued; });
+		m_queue.push_back(std::move(job));
+		m_pushed++;
+		lock.unlock();
+		m_cond.notify_one();
+	}
+
+	/**
+	 * @brief Wait until all the jobs queued so far are run and committed
+	 * @return false if some job (or a commit) failed since the last flush(), see lastError().
+	 */
+	bool flush() {
+		std::unique_lock lock(m_lock);
+		const auto target = m_pushed;
+		m_flushing++;
+		m_cond.notify_one();
+		m_doneCond.wait(lock, [this, target] { return m_done >= target; });
+		m_flushing--;
+
+		const auto ret = !m_failed;
+		m_failed = false;
+
+		return ret;
+	}
+
+	/// @brief Return the last error string if some
+	std::string lastError() const {
+		std::lock_guard lock(m_lock);
+		return m_lastError;
+	}
+private:
+	void setFailed(const std::string &error) {
+		std::lock_guard lock(m_lock);
+		m_failed = true;
+		m_lastError = error;
+	}
+
+	void run() {
+		std::unique_lock lock(m_lock);
+
+		while (true) {
+			m_cond.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty())
+				break;
+
+			lock.unlock();
+			const auto deadline = std::chrono::steady_clock::now() + m_commitInterval;
+			const auto inTrans = m_conn.begin(TransactionType::IMMEDIATE);
+			if (!inTrans)
+				setFailed(m_conn.lastError());
+			lock.lock();
+
+			uint64_t processed = 0;
+			while (processed < m_commitRows) {
+				if (m_queue.empty() && (m_stop || m_flushing ||
+						!m_cond.wait_until(lock, deadline, [this] {
+							return m_stop || m_flushing || !m_queue.empty();
+						}) || m_queue.empty()))
+					break;
+				/* always run at least one job, so that the queue drains */
+				if (processed && std::chrono::steady_clock::now() >= deadline)
+					break;
+
+				auto job = std::move(m_queue.front());
+				m_queue.pop_front();
+				lock.unlock();
+				m_spaceCond.notify_one();
+
+				const auto saved = inTrans && m_conn.savepoint("job");
+				if (inTrans && !saved)
+					setFailed(m_conn.lastError());
+				if (!job(m_conn)) {
+					setFailed(m_conn.lastError());
+					if (saved)
+						m_conn.rollbackTo("job");
+				}
+				if (saved && !m_conn.release("job"))
+					setFailed(m_conn.lastError());
+				processed++;
+				lock.lock();
+			}
+
+			lock.unlock();
+			if (inTrans && !m_conn.end())
+				setFailed(m_conn.lastError());
+			lock.lock();
+
+			m_done += processed;
+			m_doneCond.notify_all();
+		}
+	}
+
+	const Conn &m_conn;
+	const unsigned m_commitRows;
+	const std::chrono::milliseconds m_commitInterval;
+	const size_t m_maxQueued;
+
+	mutable std::mutex m_lock;
+	std::condition_variable m_cond;
+	std::condition_variable m_spaceCond;
+	std::condition_variable m_doneCond;
+	std::deque<Job> m_queue;
+	uint64_t m_pushed;
+	uint64_t m_done;
+	unsigned m_flushing;
+	bool m_stop;
+	bool m_failed;
+	std::string m_lastError;
+	std::thread m_thread;
+};
+
+}
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <tuple>
+
 #include "../helpers/Unique.h"
 
 struct sqlite3;
@@ -12,6 +14,21 @@ namespace SlSqlite {
 using SQLHolder = SlHelpers::UniqueHolder<sqlite3>;
 using SQLStmtHolder = SlHelpers::UniqueHolder<sqlite3_stmt>;
 
+/**
+ * @brief SQLStmtHolder with compile-time known types of parameters
+ *
+ * The N-th of \p Args is bound to the N-th distinct parameter in the SQL (this is how SQLite
+ * numbers them). Prepare it as any other SQLStmtHolder and pass the values as a tuple to
+ * SQLConn::insert() or SQLConn::select(). Supported types are \c int, \c unsigned, \c int64_t,
+ * \c double, \c std::string_view, \c std::string, \c SQLConn::Blob, and \c std::optional of
+ * those (for NULL).
+ */
+template <typename... Args>
+struct TypedStmtHolder : public SQLStmtHolder {
+	/// @brief Values to bind to this statement
+	using Values = std::tuple<Args...>;
+};
+
 /**
  * @brief Resets SQLite statement after use for re-use
  */
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <variant>
+
+#include "SQLConn.h"
+
+namespace SlSqlite {
+
+/**
+ * @brief Lazily stepped SELECT (a cursor)
+ *
+ * Unlike SQLConn::select(), nothing is materialized. Rows are returned as RowView which reads
+ * the columns directly from the statement, so the returned text is valid only until the next
+ * step. The statement is reset when Select dies.
+ * \code
+ * Select sel(*this, selPerson, { { ":name", name } });
+ * for (const auto &row : sel) {
+ *	if (row.getText(0) == "John")
+ *		break;
+ * }
+ * if (sel.failed())
+ *	return false;
+ * \endcode
+ */
+class Select {
+public:
+	/// @brief One column returned by RowView::column(), see SQLConn::Column
+	using ColumnView = std::variant<std::monostate, int, std::string_view, int64_t, double,
+					std::span<const std::byte>>;
+
+	/**
+	 * @brief A view of the current row of a Select
+	 */
+	class RowView {
+	public:
+		/// @brief Return the count of columns in this row
+		int columns() const noexcept;
+		/// @brief Return true if column \p col is NULL
+		bool isNull(int col) const noexcept;
+		/// @brief Return column \p col as an int
+		int getInt(int col) const noexcept;
+		/// @brief Return column \p col as a 64-bit int
+		int64_t getInt64(int col) const noexcept;
+		/// @brief Return column \p col as a double
+		double getDouble(int col) const noexcept;
+		/// @brief Return column \p col as a text (valid until the next step)
+		std::string_view getText(int col) const noexcept;
+		/// @brief Return column \p col as a blob (valid until the next step)
+		std::span<const std::byte> getBlob(int col) const noexcept;
+		/// @brief Return column \p col according to its type
+		ColumnView column(int col) const noexcept;
+		/// @brief Return column \p col according to its type
+		ColumnView operator[](int col) const noexcept { return column(col); }
+	private:
+		friend class Select;
+		RowView(sqlite3_stmt *stmt) : m_stmt(stmt) {}
+
+		sqlite3_stmt *m_stmt;
+	};
+
+	/**
+	 * @brief Input iterator over the rows of a Select
+	 */
+	class iterator {
+	public:
+		/// @brief Iterator category (single pass)
+		using iterator_category = std::input_iterator_tag;
+		/// @brief Value type
+		using value_type = RowView;
+		/// @brief Difference type
+		using difference_type = std::ptrdiff_t;
+
+		iterator() : m_sel(nullptr) {}
+
+		/// @brief Return the current row
+		const RowView &operator*() const { return m_sel->m_row; }
+		/// @brief Return the current row
+		const RowView *operator->() const { return &m_sel->m_row; }
+		/// @brief Step to the next row
+		iterator &operator++() { m_sel->step(); return *this; }
+		/// @brief Step to the next row
+		void operator++(int) { ++*this; }
+		/// @brief Test whether there are no more rows
+		bool operator==(std::default_sentinel_t) const { return m_sel->m_done; }
+	private:
+		friend class Select;
+		iterator(Select *sel) : m_sel(sel) {}
+
+		Select *m_sel;
+	};
+
+	/**
+	 * @brief Bind \p binding to \p sel, prepared in \p conn
+	 * @param conn Connection where \p sel was prepared (errors are reported there)
+	 * @param sel Statement to step
+	 * @param binding Values to bind
+	 */
+	Select(const SQLConn &conn, const SQLStmtHolder &sel, const SQLConn::Binding &binding = {});
+
+	/**
+	 * @brief Bind \p vals to \p sel, prepared in \p conn
+	 * @param conn Connection where \p sel was prepared (errors are reported there)
+	 * @param sel Statement to step
+	 * @param vals Values to bind
+	 */
+	template <typename... Args>
+	Select(const SQLConn &conn, const TypedStmtHolder<Args...> &sel,
+	       const typename TypedStmtHolder<Args...>::Values &vals)
+		: Select(conn, sel, SQLConn::Binding{}) {
+		if (!m_failed && !conn.bind(sel, vals))
+			m_started = m_done = m_failed = true;
+	}
+
+	Select(const Select &) = delete;
+	Select &operator=(const Select &) = delete;
+
+	/**
+	 * @brief Step to the next row
+	 * @return true if a row is available via row(), false at the end or on failure.
+	 */
+	bool step() noexcept;
+
+	/// @brief Return the current row (valid after a successful step())
+	const RowView &row() const { return m_row; }
+
+	/// @brief Start the iteration (steps to the first row)
+	iterator begin() {
+		if (!m_started)
+			step();
+		return iterator(this);
+	}
+	/// @brief The end of the iteration
+	std::default_sentinel_t end() const { return {}; }
+
+	/// @brief Test whether binding or some step failed (see SQLConn::lastError())
+	bool failed() const { return m_failed; }
+private:
+	const SQLConn &m_conn;
+	SQLStmtResetter m_resetter;
+	RowView m_row;
+	bool m_started;
+	bool m_done;
+	bool m_failed;
+};
+
+}
@@ -1,32 +1,67 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unistd.h>
 
 #include <curl/curl.h>
 
 #include "curl/Curl.h"
+#include "curl/MultiCurl.h"
 #include "helpers/Color.h"
 
 using namespace SlCurl;
 using Clr = SlHelpers::Color;
 
-static size_t ssWriter(const char *contents, size_t size, size_t nmemb, std::ostream *stream)
-{
-	size *= nmemb;
+/*
+ * libcurl global state + the DNS and TLS session cache shared by all handles. Connections
+ * are not shared this way (libcurl does not support that across threads), MultiCurl shares
+ * them among its transfers instead.
+ */
+static struct LibIniter {
+	LibIniter() : share(nullptr) {
+		if (curl_global_init(CURL_GLOBAL_ALL))
+			return;
 
-	stream->write(contents, size);
+		share = curl_share_init();
+		if (!share)
+			return;
+		curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock);
+		curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock);
+		curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+	~LibIniter() {
+		curl_share_cleanup(share);
+		curl_global_cleanup();
+	}
 
-	return size;
-}
+	static void lock(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+		static_cast<LibIniter *>(userptr)->locks[data].lock();
+	}
+	static void unlock(CURL *, curl_lock_data data, void *userptr) {
+		static_cast<LibIniter *>(userptr)->locks[data].unlock();
+	}
 
+	CURLSH *share;
+	std::mutex locks[CURL_LOCK_DATA_LAST];
+} LI;
+
+RetryPolicy LibCurl::m_defaultRetryPolicy;
+LibCurl::TransferObserver LibCurl::m_defaultObserver;
 thread_local std::string LibCurl::m_lastError;
 
-LibCurl::LibCurl() : handle(nullptr)
+LibCurl::LibCurl() : handle(nullptr), m_retryPolicy(m_defaultRetryPolicy),
+	m_observer(m_defaultObserver)
 {
-	if (curl_global_init(CURL_GLOBAL_ALL)) {
+	if (!LI.share) {
 		m_lastError = "cannot init libcurl";
 		return;
 	}
@@ -37,68 +72,280 @@ LibCurl::LibCurl() : handle(nullptr)
 		return;
 	}
 	curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
-	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, ssWriter);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, Sink::write);
 	curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+	curl_easy_setopt(handle, CURLOPT_SHARE, LI.share);
+	curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+	setCompression(true);
 }
 
 LibCurl::~LibCurl()
 {
 	curl_easy_cleanup(handle);
-	curl_global_cleanup();
 }
 
-bool LibCurl::downloadToStream(const std::string &url, const std::ostream &stream,
-			       unsigned *HTTPErrorCode)
+void LibCurl::setCompression(bool enable)
+{
+	/* "" means all encodings this libcurl supports */
+	curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, enable ? "" : nullptr);
+}
+
+LibCurl &LibCurl::threadLocal()
+{
+	static thread_local LibCurl curl;
+
+	return curl;
+}
+
+size_t LibCurl::Sink::write(const char *contents, size_t size, size_t nmemb, void *userdata)
+{
+	auto &sink = *static_cast<Sink *>(userdata);
+	const std::string_view data(contents, size * nmemb);
+
+	if (auto stream = std::get_if<std::ostream *>(&sink.m_target)) {
+		if (!(*stream)->write(data.data(), data.size()))
+			return 0;
+	} else if (auto str = std::get_if<std::string *>(&sink.m_target)) {
+		auto &s = **str;
+		curl_off_t length;
+		/*
+		 * Only once: with compression, Content-Length is the compressed size and
+		 * reserving it repeatedly would defeat the geometric growth of append().
+		 */
+		if (!sink.m_written &&
+				!curl_easy_getinfo(sink.m_handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+						   &length) &&
+				length > 0)
+			s.reserve(s.size() + length);
+		s.append(data);
+	} else if (auto CB = std::get_if<const ChunkCallback *>(&sink.m_target)) {
+		if (!(**CB)(data))
+			return 0;
+	} else if (!sink.writeFD(std::get<int>(sink.m_target), data)) {
+		return 0;
+	}
+
+	sink.m_written += data.size();
+
+	return data.size();
+}
+
+bool LibCurl::Sink::writeFD(int fd, std::string_view data)
+{
+	while (!data.empty()) {
+		auto wr = ::write(fd, data.data(), data.size());
+		if (wr < 0) {
+			if (errno == EINTR)
+				continue;
+			m_errno = errno;
+			return false;
+		}
+		data.remove_prefix(wr);
+	}
+
+	return true;
+}
+
+void LibCurl::Sink::start()
+{
+	if (auto stream = std::get_if<std::ostream *>(&m_target))
+		m_start = (*stream)->tellp();
+	else if (auto str = std::get_if<std::string *>(&m_target))
+		m_start = (*str)->size();
+	else if (auto fd = std::get_if<int>(&m_target))
+		m_start = ::lseek(*fd, 0, SEEK_CUR);
+}
+
+bool LibCurl::Sink::rewind()
 {
+	if (m_written) {
+		if (auto stream = std::get_if<std::ostream *>(&m_target)) {
+			if (m_start < 0 || !(*stream)->seekp(m_start))
+				return false;
+		} else if (auto str = std::get_if<std::string *>(&m_target)) {
+			(*str)->resize(m_start);
+		} else if (auto fd = std::get_if<int>(&m_target)) {
+			if (m_start < 0 || ::ftruncate(*fd, m_start) ||
+					::lseek(*fd, m_start, SEEK_SET) < 0)
+				return false;
+		} else {
+			return false;
+		}
+	}
+
+	m_written = 0;
+	m_errno = 0;
+
+	return true;
+}
+
+void LibCurl::prepare(const std::string &url, Sink &sink)
+{
+	sink.m_handle = handle;
+	sink.start();
 	curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
-	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &stream);
-	auto ret = curl_easy_perform(handle);
+	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &sink);
+}
+
+bool LibCurl::finish(const std::string &url, int ret, const Sink &sink, unsigned attempt,
+		     unsigned *HTTPErrorCode, std::string &error)
+{
 	long resp = 0;
 	curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &resp);
+
+	const auto getInfo = [this](CURLINFO info) -> curl_off_t {
+		curl_off_t val = 0;
+		curl_easy_getinfo(handle, info, &val);
+		return val;
+	};
+	m_lastTransfer.compressedBytes = getInfo(CURLINFO_SIZE_DOWNLOAD_T);
+	m_lastTransfer.uncompressedBytes = sink.written();
+	m_lastTransfer.bytesPerSec = getInfo(CURLINFO_SPEED_DOWNLOAD_T);
+	m_lastTransfer.nameLookup = std::chrono::microseconds(getInfo(CURLINFO_NAMELOOKUP_TIME_T));
+	m_lastTransfer.connect = std::chrono::microseconds(getInfo(CURLINFO_CONNECT_TIME_T));
+	m_lastTransfer.TLSHandshake =
+		std::chrono::microseconds(getInfo(CURLINFO_APPCONNECT_TIME_T));
+	m_lastTransfer.firstByte =
+		std::chrono::microseconds(getInfo(CURLINFO_STARTTRANSFER_TIME_T));
+	m_lastTransfer.total = std::chrono::microseconds(getInfo(CURLINFO_TOTAL_TIME_T));
+	m_lastTransfer.attempt = attempt + 1;
+
+	if (m_observer)
+		m_observer(url, ret == CURLE_OK, m_lastTransfer);
+
 	if (HTTPErrorCode)
 		*HTTPErrorCode = resp;
 	if (ret != CURLE_OK) {
-		m_lastError = "curl_easy_perform() failed (resp=" + std::to_string(resp) + "): " +
-				curl_easy_strerror(ret);
+		error = "curl_easy_perform() failed (resp=" + std::to_string(resp) + "): " +
+				curl_easy_strerror(static_cast<CURLcode>(ret));
+		if (sink.writeErrno())
+			error.append(": ").append(std::strerror(sink.writeErrno()));
 		return false;
 	}
 
 	return true;
 }
 
+bool LibCurl::shouldRetry(int ret, unsigned HTTPErrorCode, unsigned attempt, Sink &sink) const
+{
+	if (attempt >= m_retryPolicy.maxRetries)
+		return false;
+
+	switch (ret) {
+	case CURLE_COULDNT_RESOLVE_PROXY:
+	case CURLE_COULDNT_RESOLVE_HOST:
+	case CURLE_COULDNT_CONNECT:
+	case CURLE_PARTIAL_FILE:
+	case CURLE_OPERATION_TIMEDOUT:
+	case CURLE_SSL_CONNECT_ERROR:
+	case CURLE_GOT_NOTHING:
+	case CURLE_SEND_ERROR:
+	case CURLE_RECV_ERROR:
+	case CURLE_HTTP2:
+	case CURLE_HTTP2_STREAM:
+		break;
+	case CURLE_HTTP_RETURNED_ERROR:
+		if (HTTPErrorCode == 408 || HTTPErrorCode == 429 || HTTPErrorCode >= 500)
+			break;
+		return false;
+	default:
+		return false;
+	}
+
+	return sink.rewind();
+}
+
+std::chrono::milliseconds LibCurl::retryDelay(unsigned attempt) const
+{
+	auto delay = m_retryPolicy.initialDelay;
+	for (auto i = 0U; i < attempt && delay < m_retryPolicy.maxDelay; ++i)
+		delay *= 2;
+	delay = std::min(delay, m_retryPolicy.maxDelay);
+
+	if (m_retryPolicy.jitter && delay.count() > 1) {
+		static thread_local std::mt19937 gen { std::random_device{}() };
+		std::uniform_int_distribution<std::chrono::milliseconds::rep> dist(delay.count() / 2,
+										    delay.count());
+		delay = std::chrono::milliseconds(dist(gen));
+	}
+
+	return delay;
+}
+
+bool LibCurl::perform(const std::string &url, Sink &&sink, unsigned *HTTPErrorCode)
+{
+	prepare(url, sink);
+
+	for (auto attempt = 0U; ; ++attempt) {
+		unsigned resp;
+		const auto ret = curl_easy_perform(handle);
+		if (finish(url, ret, sink, attempt, &resp, m_lastError) ||
+				!shouldRetry(ret, resp, attempt, sink)) {
+			if (HTTPErrorCode)
+				*HTTPErrorCode = resp;
+			return ret == CURLE_OK;
+		}
+
+		std::this_thread::sleep_for(retryDelay(attempt));
+	}
+}
+
+bool LibCurl::downloadToStream(const std::string &url, std::ostream &stream,
+			       unsigned *HTTPErrorCode)
+{
+	return perform(url, Sink(&stream), HTTPErrorCode);
+}
+
+bool LibCurl::downloadToString(const std::string &url, std::string &str, unsigned *HTTPErrorCode)
+{
+	return perform(url, Sink(&str), HTTPErrorCode);
+}
+
+bool LibCurl::downloadChunks(const std::string &url, const ChunkCallback &CB,
+			     unsigned *HTTPErrorCode)
+{
+	return perform(url, Sink(&CB), HTTPErrorCode);
+}
+
 bool LibCurl::downloadToFile(const std::string &url, const std::filesystem::path &file,
 			     unsigned *HTTPErrorCode)
 {
-	std::ofstream fs(file);
-	if (!fs)
+	const auto fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		m_lastError = "cannot open " + file.string() + ": " + std::strerror(errno);
 		return false;
+	}
+
+	auto ret = perform(url, Sink(fd), HTTPErrorCode);
 
-	return downloadToStream(url, fs, HTTPErrorCode);
+	if (::close(fd) && ret) {
+		m_lastError = "cannot write " + file.string() + ": " + std::strerror(errno);
+		return false;
+	}
+
+	return ret;
 }
 
 std::optional<std::string> LibCurl::download(const std::string &url, unsigned *HTTPErrorCode)
 {
-	std::ostringstream ss;
+	std::string str;
 
-	if (!downloadToStream(url, ss, HTTPErrorCode))
+	if (!downloadToString(url, str, HTTPErrorCode))
 		return {};
 
-	return ss.str();
+	return str;
 }
 
 std::optional<std::string> LibCurl::singleDownload(const std::string &url, unsigned *HTTPErrorCode)
 {
-	LibCurl curl;
-
-	return curl.download(url, HTTPErrorCode);
+	return threadLocal().download(url, HTTPErrorCode);
 }
 
 bool LibCurl::singleDownloadToFile(const std::string &url, const std::filesystem::path &file,
 				   unsigned *HTTPErrorCode)
 {
-	LibCurl curl;
-
-	return curl.downloadToFile(url, file, HTTPErrorCode);
+	return threadLocal().downloadToFile(url, file, HTTPErrorCode);
 }
 
 bool LibCurl::isDownloadNeeded(const std::filesystem::path &filePath, bool &fileAlreadyExists,
@@ -117,6 +364,38 @@ bool LibCurl::isDownloadNeeded(const std::filesystem::path &filePath, bool &file
 	return mtime < now - hours;
 }
 
+LibCurl::FetchStatus LibCurl::fetchDone(const std::filesystem::path &filePath,
+					 const std::filesystem::path &newPath,
+					 const std::string &url, bool fileAlreadyExists,
+					 bool ignoreErrors, bool success, unsigned http_code,
+					 const std::string &error)
+{
+	const auto failed = fileAlreadyExists && !ignoreErrors ? FetchStatus::STALE :
+								  FetchStatus::FAILED;
+	if (!success) {
+		if (ignoreErrors)
+			return failed;
+		Clr(std::cerr, Clr::RED) << "Failed to fetch " << url << " to " << filePath <<
+					    ": " << error;
+		return failed;
+	}
+	if (http_code >= 400) {
+		if (ignoreErrors)
+			return failed;
+		Clr(std::cerr, Clr::RED) << "Failed to fetch " << url << " (" << http_code <<
+					    ") " << " to " << filePath;
+		return failed;
+	}
+	std::error_code ec;
+	std::filesystem::rename(newPath, filePath, ec);
+	if (ec) {
+		Clr(std::cerr, Clr::RED) << "Failed to rename " << newPath << " to " << filePath;
+		return FetchStatus::FAILED;
+	}
+
+	return FetchStatus::DOWNLOADED;
+}
+
 std::filesystem::path LibCurl::fetchFileIfNeeded(const std::filesystem::path &filePath,
 						 const std::string &url,
 						 bool forceRefresh, bool ignoreErrors,
@@ -131,31 +410,42 @@ std::filesystem::path LibCurl::fetchFileIfNeeded(const std::filesystem::path &fi
 
 	auto newPath(filePath);
 	newPath += ".NEW";
-	unsigned http_code;
-	if (!singleDownloadToFile(url, newPath, &http_code)) {
-		if (ignoreErrors)
-			return "";
-		Clr(std::cerr, Clr::RED) << "Failed to fetch " << url << " to " << filePath <<
-					    ": " << m_lastError;
-		if (fileAlreadyExists)
-			return filePath;
-		return "";
-	}
-	if (http_code >= 400) {
-		if (ignoreErrors)
-			return "";
-		Clr(std::cerr, Clr::RED) << "Failed to fetch " << url << " (" << http_code <<
-					    ") " << " to " << filePath;
-		if (fileAlreadyExists)
-			return filePath;
+	unsigned http_code = 0;
+	const auto success = singleDownloadToFile(url, newPath, &http_code);
+	if (fetchDone(filePath, newPath, url, fileAlreadyExists, ignoreErrors, success, http_code,
+		      m_lastError) == FetchStatus::FAILED)
 		return "";
-	}
-	std::error_code ec;
-	std::filesystem::rename(newPath, filePath, ec);
-	if (ec) {
-		Clr(std::cerr, Clr::RED) << "Failed to rename " << newPath << " to " << filePath;
-		return "";
-	}
 
 	return filePath;
 }
+
+std::vector<LibCurl::FetchStatus>
+LibCurl::fetchFilesIfNeeded(const std::vector<FetchEntry> &files, bool forceRefresh,
+			    bool ignoreErrors, unsigned maxParallel)
+{
+	std::vector<FetchStatus> ret(files.size(), FetchStatus::FRESH);
+	MultiCurl multi(maxParallel);
+
+	for (auto i = 0U; i < files.size(); ++i) {
+		const auto &entry = files[i];
+		bool fileAlreadyExists = false;
+		if (!isDownloadNeeded(entry.filePath, fileAlreadyExists, forceRefresh, entry.hours))
+			continue;
+
+		if (forceRefresh)
+			std::cout << "Downloading... " << entry.filePath << " from " <<
+				     entry.url << '\n';
+
+		auto newPath(entry.filePath);
+		newPath += ".NEW";
+		multi.add(entry.url, newPath, [&ret, &entry, i, newPath, fileAlreadyExists,
+			  ignoreErrors](MultiCurl::Result &&res) {
+			ret[i] = fetchDone(entry.filePath, newPath, entry.url, fileAlreadyExists,
+					   ignoreErrors, res.success, res.HTTPErrorCode, res.error);
+		});
+	}
+
+	multi.perform();
+
+	return ret;
+}
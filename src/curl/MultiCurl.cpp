@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <curl/curl.h>
+
+#include "curl/MultiCurl.h"
+
+using namespace SlCurl;
+
+thread_local std::string MultiCurl::m_lastError;
+
+MultiCurl::MultiCurl(unsigned maxParallel, bool http2, bool compression) :
+	m_multi(curl_multi_init()), m_maxParallel(maxParallel ? : 1), m_http2(http2),
+	m_compression(compression), m_allOK(true), m_retryPolicy(LibCurl::m_defaultRetryPolicy),
+	m_observer(LibCurl::m_defaultObserver)
+{
+	if (!m_multi) {
+		m_lastError = "failed to get curl multi handle";
+		return;
+	}
+
+	curl_multi_setopt(m_multi, CURLMOPT_PIPELINING,
+			  http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+	curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, static_cast<long>(m_maxParallel));
+}
+
+MultiCurl::~MultiCurl()
+{
+	for (const auto &t : m_running) {
+		curl_multi_remove_handle(m_multi, t.first);
+		if (t.second.fd >= 0)
+			::close(t.second.fd);
+	}
+	m_running.clear();
+	m_idle.clear();
+	curl_multi_cleanup(m_multi);
+}
+
+void MultiCurl::add(const std::string &url, const DoneCallback &CB)
+{
+	m_pending.push_back({ url, {}, {}, CB });
+}
+
+void MultiCurl::add(const std::string &url, const std::filesystem::path &file,
+		    const DoneCallback &CB)
+{
+	m_pending.push_back({ url, file, {}, CB });
+}
+
+void MultiCurl::add(const std::string &url, const LibCurl::ChunkCallback &chunkCB,
+		    const DoneCallback &CB)
+{
+	m_pending.push_back({ url, {}, chunkCB, CB });
+}
+
+std::unique_ptr<LibCurl> MultiCurl::getCurl()
+{
+	std::unique_ptr<LibCurl> curl;
+
+	if (!m_idle.empty()) {
+		curl = std::move(m_idle.back());
+		m_idle.pop_back();
+	} else {
+		curl = std::make_unique<LibCurl>();
+		if (!curl->handle)
+			return nullptr;
+
+		if (!m_http2)
+			curl_easy_setopt(curl->handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+		curl->setCompression(m_compression);
+	}
+
+	curl->setRetryPolicy(m_retryPolicy);
+	curl->setObserver(m_observer);
+
+	return curl;
+}
+
+bool MultiCurl::startPending()
+{
+	while (!m_pending.empty() && m_running.size() < m_maxParallel) {
+		auto curl = getCurl();
+		if (!curl) {
+			m_lastError = LibCurl::lastError();
+			return false;
+		}
+
+		auto req = std::move(m_pending.front());
+		m_pending.pop_front();
+
+		auto handle = curl->handle;
+		auto &transfer = m_running[handle];
+		transfer.req = std::move(req);
+		transfer.curl = std::move(curl);
+
+		if (!transfer.req.file.empty()) {
+			transfer.fd = ::open(transfer.req.file.c_str(),
+					     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (transfer.fd < 0) {
+				Result res{};
+				res.error = "cannot open " + transfer.req.file.string() + ": " +
+						std::strerror(errno);
+				auto node = m_running.extract(handle);
+				done(node.mapped(), res);
+				continue;
+			}
+			transfer.sink = LibCurl::Sink(transfer.fd);
+		} else if (transfer.req.chunkCB) {
+			transfer.sink = LibCurl::Sink(&transfer.req.chunkCB);
+		}
+
+		transfer.curl->prepare(transfer.req.url, transfer.sink);
+
+		auto ret = curl_multi_add_handle(m_multi, handle);
+		if (ret != CURLM_OK) {
+			m_lastError = std::string("curl_multi_add_handle() failed: ") +
+					curl_multi_strerror(ret);
+			fail(handle, m_lastError);
+		}
+	}
+
+	return true;
+}
+
+bool MultiCurl::processDone()
+{
+	int msgsInQueue;
+
+	while (auto msg = curl_multi_info_read(m_multi, &msgsInQueue)) {
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+
+		auto handle = msg->easy_handle;
+		auto ret = msg->data.result;
+		curl_multi_remove_handle(m_multi, handle);
+
+		auto &transfer = m_running.at(handle);
+
+		Result res{};
+		res.success = transfer.curl->finish(transfer.req.url, ret, transfer.sink,
+						    transfer.attempt, &res.HTTPErrorCode, res.error);
+		if (!res.success && transfer.curl->shouldRetry(ret, res.HTTPErrorCode,
+							       transfer.attempt, transfer.sink)) {
+			transfer.retryAt = std::chrono::steady_clock::now() +
+					transfer.curl->retryDelay(transfer.attempt);
+			transfer.attempt++;
+			m_retrying.push_back(handle);
+			continue;
+		}
+
+		/* transfer must not be used while the node owns the element */
+		auto node = m_running.extract(handle);
+		auto &finished = node.mapped();
+		res.info = finished.curl->lastTransfer();
+		if (finished.fd >= 0 && ::close(finished.fd) && res.success) {
+			res.success = false;
+			res.error = "cannot write " + finished.req.file.string() + ": " +
+					std::strerror(errno);
+		}
+		if (res.success)
+			res.content = std::move(finished.content);
+
+		done(finished, res);
+	}
+
+	return startPending();
+}
+
+bool MultiCurl::startRetries()
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	for (auto it = m_retrying.begin(); it != m_retrying.end(); ) {
+		if (m_running.at(*it).retryAt > now) {
+			++it;
+			continue;
+		}
+
+		const auto handle = *it;
+		it = m_retrying.erase(it);
+
+		auto ret = curl_multi_add_handle(m_multi, handle);
+		if (ret != CURLM_OK) {
+			m_lastError = std::string("curl_multi_add_handle() failed: ") +
+					curl_multi_strerror(ret);
+			fail(handle, m_lastError);
+		}
+	}
+
+	return true;
+}
+
+int MultiCurl::pollTimeout() const
+{
+	auto timeout = std::chrono::milliseconds(1000);
+	const auto now = std::chrono::steady_clock::now();
+
+	for (const auto handle : m_retrying) {
+		auto left = std::chrono::ceil<std::chrono::milliseconds>(
+					m_running.at(handle).retryAt - now);
+		timeout = std::clamp(left, std::chrono::milliseconds::zero(), timeout);
+	}
+
+	return timeout.count();
+}
+
+void MultiCurl::done(Transfer &transfer, Result &res)
+{
+	if (!res.success)
+		m_allOK = false;
+
+	if (transfer.curl)
+		m_idle.push_back(std::move(transfer.curl));
+
+	res.url = std::move(transfer.req.url);
+	if (transfer.req.CB)
+		transfer.req.CB(std::move(res));
+}
+
+void MultiCurl::fail(CURL *handle, std::string error)
+{
+	auto node = m_running.extract(handle);
+	auto &transfer = node.mapped();
+	if (transfer.fd >= 0)
+		::close(transfer.fd);
+
+	Result res{};
+	res.error = std::move(error);
+	done(transfer, res);
+}
+
+bool MultiCurl::perform()
+{
+	if (!m_multi)
+		return false;
+
+	m_allOK = true;
+	if (!startPending())
+		return false;
+
+	while (!m_running.empty()) {
+		if (!startRetries())
+			return false;
+
+		int running;
+		auto ret = curl_multi_perform(m_multi, &running);
+		if (ret != CURLM_OK) {
+			m_lastError = std::string("curl_multi_perform() failed: ") +
+					curl_multi_strerror(ret);
+			return false;
+		}
+
+		if (!processDone())
+			return false;
+
+		if (!running && m_running.size() > m_retrying.size())
+			continue;
+
+		ret = curl_multi_poll(m_multi, nullptr, 0, pollTimeout(), nullptr);
+		if (ret != CURLM_OK) {
+			m_lastError = std::string("curl_multi_poll() failed: ") +
+					curl_multi_strerror(ret);
+			return false;
+		}
+	}
+
+	return m_allOK;
+}
+
+std::optional<std::string> MultiCurl::download(const std::string &url, unsigned *HTTPErrorCode)
+{
+	std::optional<std::string> content;
+
+	add(url, [&content, HTTPErrorCode](Result &&res) {
+		if (HTTPErrorCode)
+			*HTTPErrorCode = res.HTTPErrorCode;
+		if (res.success)
+			content = std::move(res.content);
+		else
+			m_lastError = std::move(res.error);
+	});
+
+	perform();
+
+	return content;
+}
@@ -41,11 +41,11 @@ std::optional<CVEHashMap> CVEHashMap::create(const std::filesystem::path &vsourc
 	SHAHashMapTy shaMap;
 
 	vulns_repo->treeLookup(*subTree)->walk([&vulns_repo, &isShort, &shaMap, &cveMap]
-					       (const std::string &,
+					       (std::string_view,
 					       const SlGit::TreeEntry &entry) -> int {
 		if (entry.type() != GIT_OBJECT_BLOB)
 			return 0;
-		const std::string file = entry.name();
+		const auto file = entry.nameSV();
 		if (!file.ends_with(".sha1"))
 			return 0;
 
@@ -54,9 +54,10 @@ std::optional<CVEHashMap> CVEHashMap::create(const std::filesystem::path &vsourc
 			std::cerr << file << " doesn't seem to be a cve_number.sha1!\n";
 			return 0;
 		}
-		std::istringstream iss(vulns_repo->blobLookup(entry)->content());
-		std::string sha_hash;
-		while (iss >> sha_hash) {
+		const auto content = entry.catFileView(*vulns_repo);
+		if (!content)
+			return 0;
+		for (const auto sha_hash : SlHelpers::String::splitSV(*content, " \t\n\r\f\v")) {
 			if (!SlHelpers::String::isHex(sha_hash) || sha_hash.size() != 40) {
 				std::cerr << '"' << sha_hash <<
 					     "\" doesn't seem to be a commit hash! (from a file \"" <<
@@ -64,10 +65,10 @@ std::optional<CVEHashMap> CVEHashMap::create(const std::filesystem::path &vsourc
 				continue;
 			}
 			if (isShort)
-				shaMap.insert(std::make_pair(sha_hash.substr(0, 12), *cve_number));
+				shaMap.emplace(sha_hash.substr(0, 12), *cve_number);
 			else {
-				cveMap.insert(std::make_pair(*cve_number, sha_hash));
-				shaMap.insert(std::make_pair(std::move(sha_hash), *cve_number));
+				cveMap.emplace(*cve_number, sha_hash);
+				shaMap.emplace(sha_hash, *cve_number);
 			}
 		}
 		return 0;
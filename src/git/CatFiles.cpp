@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <git2.h>
+
+#include "git/CatFiles.h"
+#include "git/Repo.h"
+#include "git/Tree.h"
+
+using namespace SlGit;
+
+size_t CatFiles::add(const std::string &rev, const std::string &path)
+{
+	m_requests.push_back({ rev, path, nullptr });
+	return m_requests.size() - 1;
+}
+
+const Tree *CatFiles::getTree(Trees &trees, const git_oid &oid) noexcept
+{
+	if (auto it = trees.find(oid); it != trees.end())
+		return &it->second;
+
+	auto tree = m_repo.treeLookup(oid);
+	if (!tree)
+		return nullptr;
+
+	m_stats.trees++;
+	return &trees.emplace(oid, std::move(*tree)).first->second;
+}
+
+bool CatFiles::resolvePath(Trees &trees, git_oid oid, std::string_view path,
+			   std::optional<git_oid> &blobId) noexcept
+{
+	while (!path.empty()) {
+		const auto slash = path.find('/');
+		const auto name = path.substr(0, slash);
+		path.remove_prefix(slash == path.npos ? path.size() : slash + 1);
+		if (name.empty())
+			continue;
+
+		const auto tree = getTree(trees, oid);
+		if (!tree)
+			return false;
+
+		const auto entry = tree->treeEntryByName(std::string(name));
+		if (!entry)
+			return true;
+
+		oid = *entry->id();
+		if (path.empty()) {
+			if (entry->type() == GIT_OBJECT_BLOB)
+				blobId = oid;
+			return true;
+		}
+		if (entry->type() != GIT_OBJECT_TREE)
+			return true;
+	}
+
+	return true;
+}
+
+bool CatFiles::run() noexcept
+{
+	std::unordered_map<std::string, std::optional<git_oid>> revTrees;
+	Trees trees;
+
+	m_stats = {};
+	for (auto &req : m_requests) {
+		req.blob = nullptr;
+
+		auto [revIt, inserted] = revTrees.try_emplace(req.rev);
+		if (inserted) {
+			m_stats.revs++;
+			if (auto tree = m_repo.treeRevparseSingle(req.rev + "^{tree}")) {
+				const auto oid = *tree->id();
+				revIt->second = oid;
+				if (trees.emplace(oid, std::move(*tree)).second)
+					m_stats.trees++;
+			}
+		}
+		if (!revIt->second)
+			continue;
+
+		std::optional<git_oid> blobId;
+		if (!resolvePath(trees, *revIt->second, req.path, blobId))
+			return false;
+		if (!blobId)
+			continue;
+
+		auto blobIt = m_blobs.find(*blobId);
+		if (blobIt == m_blobs.end()) {
+			auto blob = m_repo.blobLookup(*blobId);
+			if (!blob)
+				return false;
+			m_stats.blobs++;
+			blobIt = m_blobs.emplace(*blobId, std::move(*blob)).first;
+		}
+		req.blob = &blobIt->second;
+	}
+
+	return true;
+}
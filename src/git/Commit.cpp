@@ -44,3 +44,10 @@ std::optional<std::string> Commit::catFile(const std::string &file) const noexce
 		return t->catFile(file);
 	return std::nullopt;
 }
+
+std::optional<BlobView> Commit::catFileView(const std::string &file) const noexcept
+{
+	if (auto t = tree())
+		return t->catFileView(file);
+	return std::nullopt;
+}
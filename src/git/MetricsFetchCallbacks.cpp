@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "git/MetricsFetchCallbacks.h"
+
+using namespace SlGit;
+
+void MetricsFetchCallbacks::reset() noexcept
+{
+	m_start = Clock::now();
+	m_last.reset();
+	m_receivedAt.reset();
+	m_samples.clear();
+}
+
+int MetricsFetchCallbacks::transferProgress(const git_indexer_progress &stats)
+{
+	const auto now = Clock::now() - m_start;
+	const auto received = stats.total_objects && stats.received_objects == stats.total_objects;
+	const Sample sample {
+		.at = now,
+		.phase = received ? Phase::RESOLVING : Phase::RECEIVING,
+		.totalObjects = stats.total_objects,
+		.receivedObjects = stats.received_objects,
+		.indexedObjects = stats.indexed_objects,
+		.localObjects = stats.local_objects,
+		.totalDeltas = stats.total_deltas,
+		.indexedDeltas = stats.indexed_deltas,
+		.receivedBytes = stats.received_bytes,
+	};
+
+	if (received && !m_receivedAt)
+		m_receivedAt = now;
+
+	const auto finished = received && stats.indexed_deltas == stats.total_deltas;
+	if (m_samples.empty() || m_samples.back().phase != sample.phase ||
+			now - m_samples.back().at >= m_interval ||
+			(finished && m_samples.back().indexedDeltas != sample.indexedDeltas))
+		m_samples.push_back(sample);
+	m_last = sample;
+
+	return m_print ? DefaultFetchCallbacks::transferProgress(stats) : 0;
+}
+
+MetricsFetchCallbacks::Summary MetricsFetchCallbacks::summary() const noexcept
+{
+	using std::chrono::duration_cast;
+	using std::chrono::milliseconds;
+
+	Summary sum{};
+	if (!m_last)
+		return sum;
+
+	const auto perSec = [](size_t count, Clock::duration took) -> double {
+		const auto secs = std::chrono::duration<double>(took).count();
+		return secs > 0 ? count / secs : 0;
+	};
+
+	const auto total = m_last->at;
+	const auto receiving = m_receivedAt.value_or(total);
+	const auto resolving = total - receiving;
+
+	sum.total = duration_cast<milliseconds>(total);
+	sum.receiving = duration_cast<milliseconds>(receiving);
+	sum.resolving = duration_cast<milliseconds>(resolving);
+	sum.objects = m_last->receivedObjects;
+	sum.localObjects = m_last->localObjects;
+	sum.deltas = m_last->indexedDeltas;
+	sum.bytes = m_last->receivedBytes;
+	sum.bytesPerSec = perSec(sum.bytes, total);
+	sum.receiveBytesPerSec = perSec(sum.bytes, receiving);
+	sum.objectsPerSec = perSec(sum.objects, receiving);
+	sum.deltasPerSec = perSec(sum.deltas, resolving);
+
+	return sum;
+}
@@ -65,6 +65,23 @@ bool RevWalk::hide(const std::string &id) const noexcept
 	return !Repo::setLastError(git_revwalk_hide(revWalk(), oid));
 }
 
+bool RevWalk::hideOlderThan(git_time_t time) noexcept
+{
+	// held on heap: libgit2 keeps the pointer and RevWalk can be moved
+	m_hideCutoff = std::make_unique<HideCutoff>(&m_repo, time);
+
+	return !Repo::setLastError(git_revwalk_add_hide_cb(revWalk(), hideCB,
+							   m_hideCutoff.get()));
+}
+
+int RevWalk::hideCB(const git_oid *oid, void *payload)
+{
+	const auto cutoff = static_cast<const HideCutoff *>(payload);
+	const auto commit = cutoff->repo->commitLookup(*oid);
+
+	return commit && commit->time() < cutoff->time;
+}
+
 std::optional<Commit> RevWalk::next() const noexcept
 {
 	git_oid oid;
@@ -47,22 +47,35 @@ int Remote::fetchUpdateRefs(const char *refname, const git_oid *a, const git_oid
 }
 #endif
 
-bool Remote::fetchRefspecs(FetchCallbacks &fc, const std::vector<std::string> &refspecs, int depth,
-			  bool tags) const noexcept
+void Remote::setupFetchOptions(git_fetch_options &out, FetchCallbacks &fc,
+				const FetchOptions &opts, const StrArray &customHeaders) noexcept
 {
-	git_fetch_options opts GIT_FETCH_OPTIONS_INIT;
-	opts.callbacks.payload = &fc;
-	opts.callbacks.credentials = fetchCredentials;
-	opts.callbacks.pack_progress = fetchPackProgress;
-	opts.callbacks.sideband_progress = fetchSidebandProgress;
-	opts.callbacks.transfer_progress = fetchTransferProgress;
+	out.callbacks.payload = &fc;
+	out.callbacks.credentials = fetchCredentials;
+	out.callbacks.pack_progress = fetchPackProgress;
+	out.callbacks.sideband_progress = fetchSidebandProgress;
+	out.callbacks.transfer_progress = fetchTransferProgress;
 #ifdef LIBGIT_HAS_UPDATE_REFS
-	opts.callbacks.update_refs = fetchUpdateRefs;
+	out.callbacks.update_refs = fetchUpdateRefs;
 #endif
-	if (!tags)
-		opts.download_tags = GIT_REMOTE_DOWNLOAD_TAGS_NONE;
-	opts.depth = depth;
-	return !Repo::setLastError(git_remote_fetch(remote(), StrArray(refspecs), &opts, nullptr));
+	if (!opts.tags)
+		out.download_tags = GIT_REMOTE_DOWNLOAD_TAGS_NONE;
+	out.depth = opts.depth;
+	if (opts.prune)
+		out.prune = GIT_FETCH_PRUNE;
+	out.update_fetchhead = opts.updateFetchHead;
+	out.custom_headers = *customHeaders.array();
+}
+
+bool Remote::fetchRefspecs(FetchCallbacks &fc, const std::vector<std::string> &refspecs,
+			   const FetchOptions &opts) const noexcept
+{
+	const StrArray customHeaders(opts.customHeaders);
+	git_fetch_options fetchOpts GIT_FETCH_OPTIONS_INIT;
+	setupFetchOptions(fetchOpts, fc, opts, customHeaders);
+
+	return !Repo::setLastError(git_remote_fetch(remote(), StrArray(refspecs), &fetchOpts,
+						    nullptr));
 }
 
 bool Remote::fetchBranches(const std::vector<std::string> &branches, int depth,
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include <git2.h>
+#include <git2/sys/commit_graph.h>
 #include <iostream>
 
 #include "git/Blob.h"
@@ -10,6 +11,7 @@
 #include "git/Repo.h"
 #include "git/Remote.h"
 #include "git/Misc.h"
+#include "git/StrArray.h"
 #include "git/Tag.h"
 #include "git/Tree.h"
 
@@ -23,6 +25,12 @@ void SlHelpers::Deleter<git_repository>::operator()(git_repository *repo) const
 	git_repository_free(repo);
 }
 
+template<>
+void SlHelpers::Deleter<git_commit_graph_writer>::operator()(git_commit_graph_writer *writer) const
+{
+	git_commit_graph_writer_free(writer);
+}
+
 thread_local SlHelpers::LastErrorStr<int, int> Repo::m_lastError;
 
 std::optional<Repo> Repo::init(const std::filesystem::path &path, bool bare,
@@ -89,6 +97,15 @@ std::optional<std::string> Repo::catFile(const std::string &branch,
 	return std::nullopt;
 }
 
+std::optional<BlobView> Repo::catFileView(const std::string &branch,
+					  const std::string &file) const noexcept
+{
+	if (auto commit = commitRevparseSingle(branch))
+		return commit->catFileView(file);
+
+	return std::nullopt;
+}
+
 std::optional<Blob> Repo::blobCreateFromWorkDir(const std::filesystem::path &file) const noexcept
 {
 	git_oid oid;
@@ -293,6 +310,44 @@ std::optional<RevWalk> Repo::revWalkCreate() const noexcept
 	return MakeGitRepo<RevWalk>(*this, git_revwalk_new, repo());
 }
 
+bool Repo::commitGraphWrite() const noexcept
+{
+	const auto walk = revWalkCreate();
+	if (!walk || !walk->pushGlob("*"))
+		return false;
+
+	const auto infoDir = path() / "objects/info";
+	git_commit_graph_writer_options opts GIT_COMMIT_GRAPH_WRITER_OPTIONS_INIT;
+	git_commit_graph_writer *w;
+	// the options moved from _commit() to _new() in 1.8
+#if LIBGIT2_VER_MAJOR > 1 || LIBGIT2_VER_MINOR >= 8
+	if (setLastError(git_commit_graph_writer_new(&w, infoDir.c_str(), &opts)))
+		return false;
+#else
+	if (setLastError(git_commit_graph_writer_new(&w, infoDir.c_str())))
+		return false;
+#endif
+	const SlHelpers::UniqueHolder<git_commit_graph_writer> writer(w);
+
+	if (setLastError(git_commit_graph_writer_add_revwalk(writer, *walk)))
+		return false;
+
+#if LIBGIT2_VER_MAJOR > 1 || LIBGIT2_VER_MINOR >= 8
+	return !setLastError(git_commit_graph_writer_commit(writer));
+#else
+	return !setLastError(git_commit_graph_writer_commit(writer, &opts));
+#endif
+}
+
+bool Repo::hasCommitGraph() const noexcept
+{
+	const auto infoDir = path() / "objects/info";
+	std::error_code ec;
+
+	return std::filesystem::exists(infoDir / "commit-graph", ec) ||
+		std::filesystem::exists(infoDir / "commit-graphs/commit-graph-chain", ec);
+}
+
 std::optional<Tag> Repo::tagCreate(const std::string &tagName, const Object &target,
 				   const Signature &tagger, const std::string &message,
 				   bool force) const noexcept
@@ -367,26 +422,22 @@ void Repo::checkoutProgress(const char *path, size_t completed_steps, size_t tot
 }
 
 std::optional<Repo> Repo::clone(const std::filesystem::path &path, const std::string &url,
-				FetchCallbacks &fc, const std::string &branch,
-				const unsigned int &depth, bool tags) noexcept
-{
-	git_clone_options opts GIT_CLONE_OPTIONS_INIT;
-	opts.checkout_branch = branch.empty() ? nullptr : branch.c_str();
-	opts.fetch_opts.depth = depth;
-	if (!tags)
-		opts.fetch_opts.download_tags = GIT_REMOTE_DOWNLOAD_TAGS_NONE;
-	opts.checkout_opts.progress_payload = &fc;
-	opts.checkout_opts.progress_cb = checkoutProgress;
-	opts.fetch_opts.callbacks.payload = &fc;
-	opts.fetch_opts.callbacks.credentials = Remote::fetchCredentials;
-	opts.fetch_opts.callbacks.pack_progress = Remote::fetchPackProgress;
-	opts.fetch_opts.callbacks.sideband_progress = Remote::fetchSidebandProgress;
-	opts.fetch_opts.callbacks.transfer_progress = Remote::fetchTransferProgress;
-#ifdef LIBGIT_HAS_UPDATE_REFS
-	opts.fetch_opts.callbacks.update_refs = Remote::fetchUpdateRefs;
-#endif
-
-	return MakeGit<Repo>(git_clone, url.c_str(), path.c_str(), &opts);
+				FetchCallbacks &fc, const CloneOptions &opts) noexcept
+{
+	const StrArray customHeaders(opts.customHeaders);
+	git_clone_options cloneOpts GIT_CLONE_OPTIONS_INIT;
+	cloneOpts.checkout_branch = opts.branch.empty() ? nullptr : opts.branch.c_str();
+	cloneOpts.bare = opts.bare;
+	cloneOpts.local = opts.local;
+	if (!opts.checkout)
+		cloneOpts.checkout_opts.checkout_strategy = GIT_CHECKOUT_NONE;
+	cloneOpts.checkout_opts.progress_payload = &fc;
+	cloneOpts.checkout_opts.progress_cb = checkoutProgress;
+	Remote::setupFetchOptions(cloneOpts.fetch_opts, fc,
+				  { .depth = static_cast<int>(opts.depth), .tags = opts.tags },
+				  customHeaders);
+
+	return MakeGit<Repo>(git_clone, url.c_str(), path.c_str(), &cloneOpts);
 }
 
 bool Repo::checkout(const std::string &branch) const noexcept
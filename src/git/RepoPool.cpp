@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <git2.h>
+
+#include "git/RepoPool.h"
+
+using namespace SlGit;
+
+const Repo *RepoPool::get() noexcept
+{
+	m_gets++;
+
+	const auto id = std::this_thread::get_id();
+	{
+		std::lock_guard lock(m_lock);
+		if (auto it = m_repos.find(id); it != m_repos.end())
+			return it->second.get();
+	}
+
+	auto repo = Repo::open(m_path);
+	if (!repo)
+		return nullptr;
+
+	std::lock_guard lock(m_lock);
+	auto &slot = m_repos[id];
+	slot = std::make_unique<Repo>(std::move(*repo));
+
+	return slot.get();
+}
+
+void RepoPool::release() noexcept
+{
+	std::unique_ptr<Repo> repo;
+	{
+		std::lock_guard lock(m_lock);
+		auto node = m_repos.extract(std::this_thread::get_id());
+		if (node)
+			repo = std::move(node.mapped());
+	}
+}
+
+RepoPool::Stats RepoPool::stats() const noexcept
+{
+	Stats stats{};
+
+	{
+		std::lock_guard lock(m_lock);
+		stats.opened = m_repos.size();
+	}
+	stats.gets = m_gets;
+	if (const auto cache = cacheStats())
+		stats.cache = *cache;
+
+	return stats;
+}
+
+bool RepoPool::setCacheLimits(const CacheLimits &limits) noexcept
+{
+	if (limits.maxSize && Repo::setLastError(git_libgit2_opts(GIT_OPT_SET_CACHE_MAX_SIZE,
+								  *limits.maxSize)))
+		return false;
+
+	const std::pair<git_object_t, const std::optional<size_t> &> objLimits[] = {
+		{ GIT_OBJECT_BLOB, limits.blobLimit },
+		{ GIT_OBJECT_TREE, limits.treeLimit },
+		{ GIT_OBJECT_COMMIT, limits.commitLimit },
+		{ GIT_OBJECT_TAG, limits.tagLimit },
+	};
+	for (const auto &[type, limit] : objLimits)
+		if (limit && Repo::setLastError(git_libgit2_opts(GIT_OPT_SET_CACHE_OBJECT_LIMIT,
+								 type, *limit)))
+			return false;
+
+	if (limits.mwindowMappedLimit &&
+			Repo::setLastError(git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT,
+							    *limits.mwindowMappedLimit)))
+		return false;
+
+	return true;
+}
+
+bool RepoPool::enableCache(bool enable) noexcept
+{
+	return !Repo::setLastError(git_libgit2_opts(GIT_OPT_ENABLE_CACHING, enable ? 1 : 0));
+}
+
+std::optional<RepoPool::CacheStats> RepoPool::cacheStats() noexcept
+{
+	CacheStats stats;
+	if (Repo::setLastError(git_libgit2_opts(GIT_OPT_GET_CACHED_MEMORY, &stats.used,
+						&stats.allowed)))
+		return std::nullopt;
+
+	return stats;
+}
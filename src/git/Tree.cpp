@@ -49,19 +49,35 @@ TreeEntry Tree::treeEntryByIndex(size_t idx) const noexcept
 	return TreeEntry(git_tree_entry_byindex(tree(), idx));
 }
 
+std::optional<TreeEntry> Tree::treeEntryByName(const std::string &name) const noexcept
+{
+	const auto TE = git_tree_entry_byname(tree(), name.c_str());
+	if (!TE)
+		return std::nullopt;
+	return TreeEntry(TE);
+}
+
 std::optional<std::string> Tree::catFile(const std::string &file) const noexcept
+{
+	if (auto view = catFileView(file))
+		return std::string(view->view());
+
+	return std::nullopt;
+}
+
+std::optional<BlobView> Tree::catFileView(const std::string &file) const noexcept
 {
 	if (auto treeEntry = treeEntryByPath(file))
-		return treeEntry->catFile(repo());
+		return treeEntry->catFileView(repo());
 
 	return std::nullopt;
 }
 
 int Tree::walkCB(const char *root, const git_tree_entry *entry, void *payload)
 {
-	const auto CB = *static_cast<Tree::WalkCallback *>(payload);
+	const auto &CB = *static_cast<Tree::WalkCallback *>(payload);
 
-	return CB(root, std::move(TreeEntry(entry)));
+	return CB(root, TreeEntry(entry));
 }
 
 bool TreeBuilder::insert(const std::filesystem::path &file, const Blob &blob) const noexcept
@@ -70,6 +86,12 @@ bool TreeBuilder::insert(const std::filesystem::path &file, const Blob &blob) co
 							  blob.id(), GIT_FILEMODE_BLOB));
 }
 
+bool TreeBuilder::insert(const std::filesystem::path &dir, const Tree &tree) const noexcept
+{
+	return !Repo::setLastError(git_treebuilder_insert(nullptr, treeBuilder(), dir.c_str(),
+							  tree.id(), GIT_FILEMODE_TREE));
+}
+
 std::optional<Tree> TreeBuilder::write(const Repo &repo) const noexcept
 {
 	git_oid oid;
@@ -80,12 +102,20 @@ std::optional<Tree> TreeBuilder::write(const Repo &repo) const noexcept
 }
 
 std::optional<std::string> TreeEntry::catFile(const Repo &repo) const noexcept
+{
+	if (auto view = catFileView(repo))
+		return std::string(view->view());
+
+	return std::nullopt;
+}
+
+std::optional<BlobView> TreeEntry::catFileView(const Repo &repo) const noexcept
 {
 	if (type() != GIT_OBJECT_BLOB)
 		return std::nullopt;
 
 	if (auto blob = repo.blobLookup(*this))
-		return blob->content();
+		return BlobView(std::move(*blob));
 
 	return std::nullopt;
 }
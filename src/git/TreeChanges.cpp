@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <git2.h>
+
+#include "git/Commit.h"
+#include "git/Repo.h"
+#include "git/StrArray.h"
+#include "git/Tree.h"
+#include "git/TreeChanges.h"
+
+using namespace SlGit;
+
+std::optional<TreeChanges> TreeChanges::create(const Repo &repo, const Tree *oldTree,
+					       const Tree *newTree, const Options &opts) noexcept
+{
+	const StrArray pathSpec(opts.pathSpec);
+	git_diff_options diffOpts GIT_DIFF_OPTIONS_INIT;
+	diffOpts.flags |= GIT_DIFF_SKIP_BINARY_CHECK;
+	diffOpts.pathspec = *pathSpec.array();
+
+	auto diff = Repo::MakeGit<Diff>(git_diff_tree_to_tree, repo.repo(),
+					oldTree ? oldTree->tree() : nullptr,
+					newTree ? newTree->tree() : nullptr, &diffOpts);
+	if (!diff)
+		return std::nullopt;
+
+	if (opts.renames) {
+		git_diff_find_options findOpts GIT_DIFF_FIND_OPTIONS_INIT;
+		findOpts.flags = GIT_DIFF_FIND_RENAMES;
+		if (opts.renameThreshold)
+			findOpts.rename_threshold = opts.renameThreshold;
+		if (Repo::setLastError(git_diff_find_similar(*diff, &findOpts)))
+			return std::nullopt;
+	}
+
+	return TreeChanges(std::move(*diff));
+}
+
+std::optional<TreeChanges> TreeChanges::create(const Repo &repo, const Commit &oldCommit,
+					       const Commit &newCommit,
+					       const Options &opts) noexcept
+{
+	const auto oldTree = oldCommit.tree();
+	if (!oldTree)
+		return std::nullopt;
+	const auto newTree = newCommit.tree();
+	if (!newTree)
+		return std::nullopt;
+
+	return create(repo, &*oldTree, &*newTree, opts);
+}
+
+TreeChanges::Change TreeChanges::operator[](size_t idx) const noexcept
+{
+	const auto delta = m_diff.getDelta(idx);
+
+	return {
+		.status = delta->status,
+		.oldPath = delta->old_file.path ? : "",
+		.newPath = delta->new_file.path ? : "",
+		.oldId = delta->old_file.id,
+		.newId = delta->new_file.id,
+		.similarity = delta->similarity,
+	};
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <git2.h>
+
+#include "git/TreeScan.h"
+
+using namespace SlGit;
+
+bool TreeScan::enumerate(const Tree &tree, const std::string &subdir)
+{
+	m_lastError.clear();
+
+	std::optional<Tree> subTree;
+	std::string prefix;
+	if (!subdir.empty()) {
+		const auto entry = tree.treeEntryByPath(subdir);
+		if (!entry || entry->type() != GIT_OBJECT_TREE) {
+			m_lastError = subdir + " is not a tree";
+			return false;
+		}
+		subTree = tree.repo().treeLookup(*entry);
+		if (!subTree) {
+			m_lastError = "cannot look up " + subdir + ": " + Repo::lastError();
+			return false;
+		}
+		prefix = subdir;
+		if (!prefix.ends_with('/'))
+			prefix.push_back('/');
+	}
+
+	const auto ret = (subTree ? *subTree : tree).walk([this, &prefix](std::string_view root,
+									  const TreeEntry &entry) {
+		if (entry.type() != GIT_OBJECT_BLOB)
+			return 0;
+
+		auto &e = m_entries.emplace_back(Entry { .path = prefix, .id = *entry.id(),
+							 .mode = entry.filemode() });
+		e.path.append(root).append(entry.nameSV());
+
+		return 0;
+	});
+	if (!ret)
+		m_lastError = "cannot walk the tree: " + Repo::lastError();
+
+	return ret;
+}
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <thread>
+
+#include <git2.h>
+
+#include "git/MetricsFetchCallbacks.h"
+#include "git/Remote.h"
+#include "git/Repo.h"
+#include "git/Updater.h"
+
+#include "helpers/Misc.h"
+
+using namespace SlGit;
+
+namespace {
+
+/// Collects the progress of one fetch into its Result, prints nothing
+class JobCallbacks : public MetricsFetchCallbacks {
+public:
+	JobCallbacks(Updater::Result &result, std::mutex &lock) : m_result(result), m_lock(lock) {}
+
+	virtual int transferProgress(const git_indexer_progress &stats) override {
+		{
+			std::lock_guard lock(m_lock);
+			m_result.totalObjects = stats.total_objects;
+			m_result.receivedObjects = stats.received_objects;
+			m_result.localObjects = stats.local_objects;
+			m_result.receivedBytes = stats.received_bytes;
+		}
+		return MetricsFetchCallbacks::transferProgress(stats);
+	}
+
+	virtual int updateRefs(std::string_view, const git_oid &, const git_oid &,
+			       git_refspec &) override {
+		std::lock_guard lock(m_lock);
+		m_result.updatedRefs++;
+		return 0;
+	}
+private:
+	Updater::Result &m_result;
+	std::mutex &m_lock;
+};
+
+const constexpr std::string_view clearLine("\33[2K\r");
+
+}
+
+void Updater::fetch(Result &result, std::mutex &lock)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const auto finish = [&result, &lock, &start](bool ok) {
+		const auto duration = std::chrono::steady_clock::now() - start;
+		std::lock_guard guard(lock);
+		result.ok = ok;
+		if (!ok)
+			result.error = Repo::lastError();
+		result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+	};
+
+	const auto repo = Repo::open(result.path);
+	if (!repo)
+		return finish(false);
+
+	const auto remote = repo->remoteLookup(result.remote);
+	if (!remote)
+		return finish(false);
+
+	JobCallbacks fc(result, lock);
+	const auto ok = remote->fetchRefspecs(fc);
+	{
+		std::lock_guard guard(lock);
+		result.metrics = fc.summary();
+	}
+	finish(ok);
+}
+
+void Updater::printProgress(const std::vector<Result> &results, size_t done)
+{
+	size_t received = 0, total = 0, bytes = 0;
+	for (const auto &r : results) {
+		received += r.receivedObjects;
+		total += r.totalObjects;
+		bytes += r.receivedBytes;
+	}
+
+	std::cerr << clearLine << "Updated " << done << '/' << results.size() <<
+		     " remotes, received " << received << '/' << total << " objects in " <<
+		     SlHelpers::Unit::human(bytes);
+}
+
+std::vector<Updater::Result> Updater::run(bool progress)
+{
+	std::vector<Result> results;
+	results.reserve(m_jobs.size());
+	for (const auto &job : m_jobs)
+		results.push_back(Result { .path = job.path, .remote = job.remote });
+
+	std::mutex lock;
+	std::condition_variable cond;
+	std::atomic<size_t> next = 0;
+	size_t done = 0;
+
+	const auto worker = [&results, &lock, &cond, &next, &done]() {
+		for (auto idx = next++; idx < results.size(); idx = next++) {
+			fetch(results[idx], lock);
+			std::lock_guard guard(lock);
+			done++;
+			cond.notify_one();
+		}
+	};
+
+	const auto nThreads = std::min<size_t>(m_threads ? : results.size(), results.size());
+	std::vector<std::thread> threads;
+	for (auto i = 0U; i < nThreads; ++i)
+		threads.emplace_back(worker);
+
+	{
+		std::unique_lock guard(lock);
+		while (!cond.wait_for(guard, std::chrono::seconds(2), [&done, &results]() {
+			return done == results.size();
+		}))
+			if (progress)
+				printProgress(results, done);
+		if (progress && !results.empty()) {
+			printProgress(results, done);
+			std::cerr << '\n';
+		}
+	}
+
+	for (auto &t : threads)
+		t.join();
+
+	return results;
+}
+
+void Updater::report(std::ostream &os, const std::vector<Result> &results)
+{
+	size_t objects = 0, bytes = 0;
+	std::chrono::milliseconds longest{};
+
+	for (const auto &r : results) {
+		os << r.path.string() << ' ' << r.remote << ": ";
+		if (r.ok) {
+			const auto rate = static_cast<size_t>(r.metrics.receiveBytesPerSec);
+			os << r.receivedObjects << " objects (" << r.localObjects << " local), " <<
+			      SlHelpers::Unit::human(r.receivedBytes) << " (" <<
+			      SlHelpers::Unit::human(rate) << "/s), " <<
+			      r.updatedRefs << " refs updated";
+		} else
+			os << "FAILED (" << r.error << ')';
+		os << " in " << r.duration.count() << " ms\n";
+		objects += r.receivedObjects;
+		bytes += r.receivedBytes;
+		longest = std::max(longest, r.duration);
+	}
+
+	os << "Total: " << objects << " objects, " << SlHelpers::Unit::human(bytes) <<
+	      " from " << results.size() << " remotes, the longest took " << longest.count() <<
+	      " ms\n";
+}
@@ -49,16 +49,16 @@ CollectConfigs::CollectConfigs(const SlGit::Commit &commit)
 
 	std::string err;
 
-	auto ret = configTree->walk([this, &repo, &err](const std::string &root,
+	auto ret = configTree->walk([this, &repo, &err](std::string_view root,
 				const SlGit::TreeEntry &entry) -> int {
 		if (entry.type() != GIT_OBJECT_BLOB)
 			return 0;
-		auto flavor = entry.name();
+		const auto flavor = entry.nameSV();
 		if (flavor == "vanilla")
 			return 0;
 		try {
-			processFlavor(repo, root.substr(0, root.size() - 1), std::move(flavor),
-				      entry);
+			processFlavor(repo, std::string(root.substr(0, root.size() - 1)),
+				      std::string(flavor), entry);
 		} catch (const std::runtime_error &e) {
 			err = e.what();
 			return -1;
@@ -77,7 +77,7 @@ CollectConfigs::CollectConfigs(const SlGit::Commit &commit)
 void CollectConfigs::processFlavor(const SlGit::Repo &repo, std::string &&arch,
 				   std::string &&flavor, const SlGit::TreeEntry &treeEntry)
 {
-	auto config = treeEntry.catFile(repo);
+	auto config = treeEntry.catFileView(repo);
 	if (!config)
 		RunEx("Failed to read config file for \"") << arch << '/' << flavor << '/' <<
 			treeEntry.name() << "\": " << repo.lastError() << raise;
@@ -2,6 +2,7 @@
 
 #include <fstream>
 
+#include "git/Blob.h"
 #include "git/Repo.h"
 #include "helpers/String.h"
 #include "kerncvs/Maintainers.h"
@@ -60,7 +61,7 @@ bool Maintainers::loadUpstream(const std::filesystem::path &lsource, const std::
 		return false;
 	}
 
-	auto maintOpt = linux_repo->catFile(origin + "/master", "MAINTAINERS");
+	auto maintOpt = linux_repo->catFileView(origin + "/master", "MAINTAINERS");
 	if (!maintOpt) {
 		std::cerr << "Unable to load linux.git tree for " << origin << "/master; " <<
 			     git_error_last()->message << '\n';
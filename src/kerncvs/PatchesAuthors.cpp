@@ -188,7 +188,7 @@ bool PatchesAuthors::consumeParens(std::string_view ref, const char *&parenStart
 	return false;
 }
 
-int PatchesAuthors::processPatch(const std::filesystem::path &file, const std::string &content)
+int PatchesAuthors::processPatch(const std::filesystem::path &file, std::string_view content)
 {
 	std::vector<std::string> patchEmails;
 	std::vector<std::string_view> patchRefs;
@@ -269,13 +269,15 @@ bool PatchesAuthors::processAuthors(const SlGit::Commit &commit, const InsertUse
 	auto patchesSuseTree = repo->treeLookup(*patchesSuseTreeEntry);
 	if (!patchesSuseTree)
 		return false;
-	if (!patchesSuseTree->walk([this](const std::string &root,
+	if (!patchesSuseTree->walk([this](std::string_view root,
 					 const SlGit::TreeEntry &entry) -> int {
 		auto blob = repo->blobLookup(entry);
 		if (!blob)
 			return -1000;
 
-		return processPatch(root + entry.name(), blob->content());
+		std::filesystem::path file(root);
+		file += entry.nameSV();
+		return processPatch(file, blob->contentView());
 	    }))
 		return false;
 
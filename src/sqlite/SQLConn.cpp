@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <algorithm>
 #include <chrono>
+#include <iostream>
 #include <optional>
 #include <sqlite3.h>
 #include <thread>
@@ -8,20 +10,41 @@
 #include "helpers/PtrStore.h"
 #include "helpers/String.h"
 #include "sqlite/SQLConn.h"
+#include "sqlite/Select.h"
 
 using namespace SlSqlite;
 
 using CharPtrStore = SlHelpers::PtrStore<char, decltype([](void* p) { sqlite3_free(p); })>;
 
-int SQLConn::busyHandler(void *, int count)
+int SQLConn::busyHandler(void *ctx, int count)
 {
-	static const auto WAIT_INTVAL = std::chrono::milliseconds(20);
-	static const auto WAIT_TIMEOUT = std::chrono::seconds(10) / WAIT_INTVAL;
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
 
-	if (count >= WAIT_TIMEOUT)
+	auto busy = static_cast<Busy *>(ctx);
+	const auto now = std::chrono::steady_clock::now();
+
+	if (!count) {
+		busy->start = now;
+		busy->stats.waits++;
+	}
+
+	const auto waited = duration_cast<microseconds>(now - busy->start);
+	busy->stats.maxWait = std::max(busy->stats.maxWait, waited);
+	if (waited >= busy->policy.deadline) {
+		busy->stats.timeouts++;
 		return 0;
+	}
 
-	std::this_thread::sleep_for(WAIT_INTVAL);
+	auto delay = busy->policy.initialDelay;
+	for (auto i = 0; i < count && delay < busy->policy.maxDelay; ++i)
+		delay *= 2;
+	delay = std::min({ delay, busy->policy.maxDelay,
+			   duration_cast<microseconds>(busy->policy.deadline) - waited });
+
+	std::this_thread::sleep_for(delay);
+	busy->stats.sleeps++;
+	busy->stats.waited += delay;
 
 	return 1;
 }
@@ -41,6 +64,15 @@ bool SQLConn::openDB(const std::filesystem::path &dbFile, OpenFlags flags) noexc
 	if (hasFlag(flags, OpenFlags::CREATE))
 		openFlags |= SQLITE_OPEN_CREATE;
 
+	if (hasFlag(flags, OpenFlags::SHARED_CACHE))
+		openFlags |= SQLITE_OPEN_SHAREDCACHE;
+
+	if (hasFlag(flags, OpenFlags::URI))
+		openFlags |= SQLITE_OPEN_URI;
+
+	if (hasFlag(flags, OpenFlags::MEMORY))
+		openFlags |= SQLITE_OPEN_MEMORY;
+
 	auto ret = sqlite3_open_v2(dbFile.c_str(), &sql, openFlags, nullptr);
 	sqlHolder.reset(sql);
 	if (ret != SQLITE_OK) {
@@ -52,15 +84,258 @@ bool SQLConn::openDB(const std::filesystem::path &dbFile, OpenFlags flags) noexc
 		if (!exec("PRAGMA foreign_keys = ON;", "db PRAGMA failed"))
 			return false;
 
-	ret = sqlite3_busy_handler(sqlHolder, busyHandler, nullptr);
+	ret = sqlite3_busy_handler(sqlHolder, busyHandler, &busy());
 	if (ret != SQLITE_OK) {
 		setError(ret, "db busy_handler failed");
 		return false;
 	}
 
+	if (hasFlag(flags, OpenFlags::BULK_LOAD))
+		return beginBulkLoad();
+
+	return true;
+}
+
+int SQLConn::traceProfile(unsigned type, void *ctx, void *P, void *X)
+{
+	if (type != SQLITE_TRACE_PROFILE)
+		return 0;
+
+	auto profiler = static_cast<Profiler *>(ctx);
+	auto stmt = static_cast<sqlite3_stmt *>(P);
+	const auto elapsed = std::chrono::nanoseconds(*static_cast<sqlite3_int64 *>(X));
+	const auto sql = sqlite3_sql(stmt) ? : "";
+
+	auto &prof = profiler->stmts[sql];
+	if (!prof.calls)
+		prof.sql = sql;
+	prof.calls++;
+	prof.total += elapsed;
+	prof.max = std::max(prof.max, elapsed);
+	prof.vmSteps += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, true);
+	prof.fullScanSteps += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, true);
+	prof.sorts += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, true);
+	prof.autoIndexRows += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, true);
+
+	if (profiler->slowThreshold.count() && elapsed >= profiler->slowThreshold) {
+		prof.slowCalls++;
+		CharPtrStore expanded(sqlite3_expanded_sql(stmt));
+		std::cerr << "slow query (" <<
+			     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() <<
+			     " ms): " << (expanded ? expanded.str() : sql) << '\n';
+	}
+
+	return 0;
+}
+
+bool SQLConn::enableProfiling(std::chrono::milliseconds slowThreshold) noexcept
+{
+	if (!m_profiler)
+		m_profiler = std::make_unique<Profiler>();
+	m_profiler->slowThreshold = slowThreshold;
+
+	auto ret = sqlite3_trace_v2(sqlHolder, SQLITE_TRACE_PROFILE, traceProfile,
+				    m_profiler.get());
+	if (ret != SQLITE_OK) {
+		setError(ret, "db trace_v2 failed");
+		return false;
+	}
+
+	return true;
+}
+
+void SQLConn::disableProfiling() noexcept
+{
+	sqlite3_trace_v2(sqlHolder, 0, nullptr, nullptr);
+}
+
+std::vector<SQLConn::StmtProfile> SQLConn::profile() const
+{
+	std::vector<StmtProfile> ret;
+
+	if (!m_profiler)
+		return ret;
+
+	ret.reserve(m_profiler->stmts.size());
+	for (const auto &e : m_profiler->stmts)
+		ret.push_back(e.second);
+
+	std::sort(ret.begin(), ret.end(), [](const StmtProfile &a, const StmtProfile &b) {
+		return a.total > b.total;
+	});
+
+	return ret;
+}
+
+void SQLConn::dumpProfile(std::ostream &os) const
+{
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+
+	for (const auto &p : profile()) {
+		os << duration_cast<microseconds>(p.total).count() << " us total, " <<
+		      duration_cast<microseconds>(p.max).count() << " us max, " <<
+		      p.calls << " calls, " << p.vmSteps << " steps";
+		if (p.fullScanSteps)
+			os << ", " << p.fullScanSteps << " full-scan steps";
+		if (p.sorts)
+			os << ", " << p.sorts << " sorts";
+		if (p.autoIndexRows)
+			os << ", " << p.autoIndexRows << " auto-index rows";
+		if (p.slowCalls)
+			os << ", " << p.slowCalls << " slow calls";
+		os << "\n\t" << p.sql << '\n';
+	}
+}
+
+std::optional<std::string> SQLConn::pragma(std::string_view name) const noexcept
+{
+	SQLStmtHolder stmt;
+	if (!prepareStatement("PRAGMA " + std::string(name) + ";", stmt))
+		return std::nullopt;
+
+	const auto ret = sqlite3_step(stmt);
+	if (ret != SQLITE_ROW) {
+		setError(ret, "db PRAGMA " + std::string(name) + " failed", true);
+		return std::nullopt;
+	}
+
+	const auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+	return text ? text : "";
+}
+
+bool SQLConn::beginBulkLoad() noexcept
+{
+	/* do not overwrite the settings to restore by the bulk ones */
+	if (m_bulkLoad)
+		return true;
+
+	std::string restore;
+	for (const auto name : { "journal_mode", "synchronous", "cache_size", "temp_store" }) {
+		const auto val = pragma(name);
+		if (!val)
+			return false;
+		restore.append("PRAGMA ").append(name).append(" = ").append(*val).append(";");
+	}
+
+	if (!exec("PRAGMA journal_mode = WAL;"
+		  "PRAGMA synchronous = OFF;"
+		  "PRAGMA cache_size = -262144;"
+		  "PRAGMA temp_store = MEMORY;", "db PRAGMA (bulk load) failed"))
+		return false;
+
+	m_bulkLoad = true;
+	m_bulkRestore = std::move(restore);
+
+	return true;
+}
+
+bool SQLConn::endBulkLoad() noexcept
+{
+	if (!m_bulkLoad)
+		return true;
+
+	m_bulkLoad = false;
+
+	const auto indices = std::move(m_deferredIndices);
+	const auto triggers = std::move(m_deferredTriggers);
+	m_deferredIndices.clear();
+	m_deferredTriggers.clear();
+
+	auto ret = createIndices(indices);
+	ret = createTriggers(triggers) && ret;
+	ret = exec(m_bulkRestore + "PRAGMA optimize;", "db PRAGMA (bulk load end) failed") && ret;
+
+	return ret;
+}
+
+bool SQLConn::backup(sqlite3 *dest, sqlite3 *src, const BackupProgress &progress,
+		     int pagesPerStep) const noexcept
+{
+	auto bck = sqlite3_backup_init(dest, "main", src, "main");
+	if (!bck) {
+		m_lastError.reset() << "db backup_init failed: " << sqlite3_errmsg(dest);
+		m_lastError.set<0>(sqlite3_errcode(dest));
+		m_lastError.set<1>(sqlite3_extended_errcode(dest));
+		return false;
+	}
+
+	const auto deadline = m_busy ? m_busy->policy.deadline : BusyPolicy().deadline;
+	std::optional<std::chrono::steady_clock::time_point> busySince;
+	int ret;
+	while (true) {
+		ret = sqlite3_backup_step(bck, pagesPerStep);
+		if (ret == SQLITE_DONE)
+			break;
+		if (ret != SQLITE_OK && ret != SQLITE_BUSY && ret != SQLITE_LOCKED)
+			break;
+		if (progress && !progress(sqlite3_backup_remaining(bck),
+					  sqlite3_backup_pagecount(bck))) {
+			sqlite3_backup_finish(bck);
+			m_lastError.reset() << "db backup aborted";
+			return false;
+		}
+		if (ret == SQLITE_OK) {
+			busySince.reset();
+			continue;
+		}
+
+		/* give up if no step succeeded for the whole deadline */
+		const auto now = std::chrono::steady_clock::now();
+		if (!busySince)
+			busySince = now;
+		else if (now - *busySince >= deadline)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	if (ret == SQLITE_DONE && progress)
+		progress(0, sqlite3_backup_pagecount(bck));
+
+	sqlite3_backup_finish(bck);
+	if (ret != SQLITE_DONE) {
+		m_lastError.reset() << "db backup_step failed: " << sqlite3_errstr(ret);
+		m_lastError.set<0>(ret & 0xff);
+		m_lastError.set<1>(ret);
+		return false;
+	}
+
 	return true;
 }
 
+bool SQLConn::backupTo(const std::filesystem::path &dbFile, const BackupProgress &progress,
+		       int pagesPerStep) const noexcept
+{
+	sqlite3 *sql;
+	auto ret = sqlite3_open_v2(dbFile.c_str(), &sql,
+				   SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+	SQLHolder dest(sql);
+	if (ret != SQLITE_OK) {
+		m_lastError.reset() << "db open failed: " << sqlite3_errstr(ret) << ": " <<
+				       dbFile;
+		m_lastError.set<0>(ret);
+		return false;
+	}
+
+	return backup(dest, sqlHolder, progress, pagesPerStep);
+}
+
+bool SQLConn::restoreFrom(const std::filesystem::path &dbFile, const BackupProgress &progress,
+			  int pagesPerStep) noexcept
+{
+	sqlite3 *sql;
+	auto ret = sqlite3_open_v2(dbFile.c_str(), &sql, SQLITE_OPEN_READONLY, nullptr);
+	SQLHolder src(sql);
+	if (ret != SQLITE_OK) {
+		m_lastError.reset() << "db open failed: " << sqlite3_errstr(ret) << ": " <<
+				       dbFile;
+		m_lastError.set<0>(ret);
+		return false;
+	}
+
+	return backup(sqlHolder, src, progress, pagesPerStep);
+}
+
 bool SQLConn::attach(const std::filesystem::path &dbFile,
 		     std::string_view dbName) const noexcept
 {
@@ -91,6 +366,11 @@ bool SQLConn::createTables(const Tables &tables) const noexcept
 
 bool SQLConn::createIndices(const Indices &indices) const noexcept
 {
+	if (m_bulkLoad) {
+		m_deferredIndices.insert(m_deferredIndices.end(), indices.begin(), indices.end());
+		return true;
+	}
+
 	for (const auto &c: indices) {
 		std::string s("CREATE INDEX IF NOT EXISTS ");
 		s.append(c.first).append(" ON ").append(c.second);
@@ -103,6 +383,12 @@ bool SQLConn::createIndices(const Indices &indices) const noexcept
 
 bool SQLConn::createTriggers(const Triggers &triggers) const noexcept
 {
+	if (m_bulkLoad) {
+		m_deferredTriggers.insert(m_deferredTriggers.end(), triggers.begin(),
+					  triggers.end());
+		return true;
+	}
+
 	for (const auto &c: triggers) {
 		std::string s("CREATE TRIGGER IF NOT EXISTS ");
 		s.append(c.first).append(" FOR EACH ROW BEGIN ").append(c.second).append("; END;");
@@ -167,6 +453,58 @@ bool SQLConn::begin(TransactionType type) const noexcept
 	return exec(stmt, "db BEGIN failed");
 }
 
+bool SQLConn::setAutoCheckpoint(int pages) const noexcept
+{
+	auto ret = sqlite3_wal_autocheckpoint(sqlHolder, std::max(pages, 0));
+	if (ret != SQLITE_OK) {
+		setError(ret, "db wal_autocheckpoint failed", true);
+		return false;
+	}
+
+	return true;
+}
+
+bool SQLConn::checkpoint(CheckpointMode mode, int *logFrames, int *checkpointed) const noexcept
+{
+	int sqlMode;
+	switch (mode) {
+	default:
+		sqlMode = SQLITE_CHECKPOINT_PASSIVE;
+		break;
+	case CheckpointMode::FULL:
+		sqlMode = SQLITE_CHECKPOINT_FULL;
+		break;
+	case CheckpointMode::RESTART:
+		sqlMode = SQLITE_CHECKPOINT_RESTART;
+		break;
+	case CheckpointMode::TRUNCATE:
+		sqlMode = SQLITE_CHECKPOINT_TRUNCATE;
+		break;
+	}
+
+	auto ret = sqlite3_wal_checkpoint_v2(sqlHolder, nullptr, sqlMode, logFrames, checkpointed);
+	if (ret != SQLITE_OK) {
+		setError(ret, "db wal_checkpoint failed", true);
+		return false;
+	}
+
+	return true;
+}
+
+bool SQLConn::inTransaction() const noexcept
+{
+	return !sqlite3_get_autocommit(sqlHolder);
+}
+
+int SQLConn::bindBlob(const SQLStmtHolder &stmt, int idx, Blob blob, void (*flag)(void *))
+{
+	/* sqlite3_bind_blob() would bind NULL for an empty span with nullptr data */
+	if (blob.empty())
+		return sqlite3_bind_zeroblob(stmt, idx, 0);
+
+	return sqlite3_bind_blob64(stmt, idx, blob.data(), blob.size(), flag);
+}
+
 bool SQLConn::bind(const SQLStmtHolder &ins, const std::string &key,
 		   const BindVal &val, bool transient) const noexcept
 {
@@ -195,6 +533,18 @@ bool SQLConn::bind(const SQLStmtHolder &ins, const std::string &key,
 		const auto &text = std::get<std::string_view>(val);
 		valDesc = text;
 		ret = sqlite3_bind_text(ins, bindIdx, text.data(), text.length(), flag);
+	} else if (std::holds_alternative<int64_t>(val)) {
+		const auto &i = std::get<int64_t>(val);
+		valDesc = std::to_string(i);
+		ret = sqlite3_bind_int64(ins, bindIdx, i);
+	} else if (std::holds_alternative<double>(val)) {
+		const auto &d = std::get<double>(val);
+		valDesc = std::to_string(d);
+		ret = sqlite3_bind_double(ins, bindIdx, d);
+	} else if (std::holds_alternative<Blob>(val)) {
+		const auto &blob = std::get<Blob>(val);
+		valDesc = "<blob of " + std::to_string(blob.size()) + " bytes>";
+		ret = bindBlob(ins, bindIdx, blob, flag);
 	} else { /* std::monostate */
 		ret = sqlite3_bind_null(ins, bindIdx);
 	}
@@ -282,28 +632,153 @@ void SQLConn::dumpBinding(const Binding &binding) const noexcept
 			m_lastError << "T:" << std::get<std::string>(b.second);
 		else if (std::holds_alternative<std::string_view>(b.second))
 			m_lastError << "T:" << std::get<std::string_view>(b.second);
+		else if (std::holds_alternative<int64_t>(b.second))
+			m_lastError << "I64:" << std::get<int64_t>(b.second);
+		else if (std::holds_alternative<double>(b.second))
+			m_lastError << "D:" << std::get<double>(b.second);
+		else if (std::holds_alternative<Blob>(b.second))
+			m_lastError << "B:" << std::get<Blob>(b.second).size() << " bytes";
 		else
 			m_lastError << "NULL";
 	}
 }
 
-bool SQLConn::insert(const SQLStmtHolder &ins, const Binding &binding,
-		     uint64_t *affected) const noexcept
+bool SQLConn::checkParamCount(const SQLStmtHolder &stmt, int count) const noexcept
 {
-	SQLStmtResetter insResetter(ins);
-
-	if (!bind(ins, binding))
+	auto params = sqlite3_bind_parameter_count(stmt);
+	if (params != count) {
+		m_lastError.reset() << "statement expects " << params << " parameters, got " <<
+				       count << "\n\t" << sqlite3_sql(stmt);
 		return false;
+	}
+
+	return true;
+}
+
+bool SQLConn::bindError(const SQLStmtHolder &stmt, int idx, int ret,
+			std::string_view val) const noexcept
+{
+	setError(ret, "db bind failed") << "\n\tidx=" << idx << " (" <<
+		(sqlite3_bind_parameter_name(stmt, idx) ? : "?") << ") val=\"" << val << '"';
+	return false;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, std::monostate) const noexcept
+{
+	auto ret = sqlite3_bind_null(stmt, idx);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, "null");
+
+	return true;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, int val) const noexcept
+{
+	auto ret = sqlite3_bind_int(stmt, idx, val);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, std::to_string(val));
+
+	return true;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, unsigned val) const noexcept
+{
+	auto ret = sqlite3_bind_int64(stmt, idx, val);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, std::to_string(val));
+
+	return true;
+}
 
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, int64_t val) const noexcept
+{
+	auto ret = sqlite3_bind_int64(stmt, idx, val);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, std::to_string(val));
+
+	return true;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, double val) const noexcept
+{
+	auto ret = sqlite3_bind_double(stmt, idx, val);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, std::to_string(val));
+
+	return true;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, Blob val) const noexcept
+{
+	auto ret = bindBlob(stmt, idx, val, SQLITE_STATIC);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret,
+				 "<blob of " + std::to_string(val.size()) + " bytes>");
+
+	return true;
+}
+
+bool SQLConn::bindOne(const SQLStmtHolder &stmt, int idx, std::string_view val) const noexcept
+{
+	auto ret = sqlite3_bind_text(stmt, idx, val.data(), val.length(), SQLITE_STATIC);
+	if (ret != SQLITE_OK)
+		return bindError(stmt, idx, ret, val);
+
+	return true;
+}
+
+bool SQLConn::stepAndReset(const SQLStmtHolder &ins, SQLStmtResetter &insResetter,
+			   uint64_t *affected) const noexcept
+{
 	bool uniqueError;
-	if (!step(ins, affected, &uniqueError)) {
-		dumpBinding(binding);
+	if (!step(ins, affected, &uniqueError))
 		return false;
-	}
 
 	auto ret = insResetter.reset();
 	if (!uniqueError && ret != SQLITE_OK) {
 		setError(ret, "db stmt reset (INSERT) failed", true);
+		return false;
+	}
+
+	return true;
+}
+
+unsigned SQLConn::batchRows(int cols) const noexcept
+{
+	auto vars = sqlite3_limit(sqlHolder, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+
+	return std::max(vars / std::max(cols, 1), 1);
+}
+
+std::string SQLConn::batchSQL(std::string_view insert, int cols, unsigned rows,
+			      std::string_view tail)
+{
+	std::string row("(?");
+	for (auto i = 1; i < cols; ++i)
+		row.append(", ?");
+	row.push_back(')');
+
+	std::string sql(insert);
+	sql.reserve(sql.size() + rows * (row.size() + 2) + tail.size() + 10);
+	sql.append(" VALUES ").append(row);
+	for (auto i = 1U; i < rows; ++i)
+		sql.append(", ").append(row);
+	if (!tail.empty())
+		sql.append(" ").append(tail);
+	sql.push_back(';');
+
+	return sql;
+}
+
+bool SQLConn::insert(const SQLStmtHolder &ins, const Binding &binding,
+		     uint64_t *affected) const noexcept
+{
+	SQLStmtResetter insResetter(ins);
+
+	if (!bind(ins, binding))
+		return false;
+
+	if (!stepAndReset(ins, insResetter, affected)) {
 		dumpBinding(binding);
 		return false;
 	}
@@ -314,46 +789,32 @@ bool SQLConn::insert(const SQLStmtHolder &ins, const Binding &binding,
 std::optional<SQLConn::SelectResult>
 SQLConn::select(const SQLStmtHolder &sel, const Binding &binding) const noexcept
 {
-	SQLStmtResetter selResetter(sel);
-	int ret;
-
-	if (!bind(sel, binding))
-		return std::nullopt;
-
+	Select cursor(*this, sel, binding);
 	SQLConn::SelectResult result;
-	while (true) {
-		ret = sqlite3_step(sel);
-		if (ret == SQLITE_DONE)
-			return result;
-		if (ret != SQLITE_ROW) {
-			setError(ret, "db step (SELECT) failed", true);
-			return std::nullopt;
-		}
 
+	for (const auto &rowView : cursor) {
 		Row row;
+		row.reserve(rowView.columns());
+
+		for (auto i = 0; i < rowView.columns(); ++i)
+			std::visit([&row](const auto &col) {
+				using T = std::decay_t<decltype(col)>;
+				if constexpr (std::is_same_v<T, std::string_view>)
+					row.emplace_back(std::string(col));
+				else if constexpr (std::is_same_v<T, std::span<const std::byte>>)
+					row.emplace_back(std::vector<std::byte>(col.begin(),
+										col.end()));
+				else
+					row.emplace_back(col);
+			}, rowView.column(i));
 
-		for (auto i = 0; i < sqlite3_data_count(sel); ++i) {
-			Column col;
-			switch (sqlite3_column_type(sel, i)) {
-			case SQLITE_INTEGER:
-				col = sqlite3_column_int(sel, i);
-				break;
-			case SQLITE_TEXT:
-				col = Column{reinterpret_cast<const char *>(sqlite3_column_text(sel, i))};
-				break;
-			case SQLITE_NULL:
-				col = std::monostate();
-				break;
-			case SQLITE_FLOAT:
-			case SQLITE_BLOB:
-			default:
-				break;
-			}
-
-			row.push_back(std::move(col));
-		}
 		result.push_back(std::move(row));
 	}
+
+	if (cursor.failed())
+		return std::nullopt;
+
+	return result;
 }
 
 SQLConn::LastError &SQLConn::setError(int ret, std::string_view error, bool errmsg) const
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <sqlite3.h>
+#include <utility>
+
+#include "sqlite/Select.h"
+
+using namespace SlSqlite;
+
+int Select::RowView::columns() const noexcept
+{
+	return sqlite3_data_count(m_stmt);
+}
+
+bool Select::RowView::isNull(int col) const noexcept
+{
+	return sqlite3_column_type(m_stmt, col) == SQLITE_NULL;
+}
+
+int Select::RowView::getInt(int col) const noexcept
+{
+	return sqlite3_column_int(m_stmt, col);
+}
+
+int64_t Select::RowView::getInt64(int col) const noexcept
+{
+	return sqlite3_column_int64(m_stmt, col);
+}
+
+double Select::RowView::getDouble(int col) const noexcept
+{
+	return sqlite3_column_double(m_stmt, col);
+}
+
+std::span<const std::byte> Select::RowView::getBlob(int col) const noexcept
+{
+	auto blob = static_cast<const std::byte *>(sqlite3_column_blob(m_stmt, col));
+	if (!blob)
+		return {};
+
+	return { blob, static_cast<size_t>(sqlite3_column_bytes(m_stmt, col)) };
+}
+
+std::string_view Select::RowView::getText(int col) const noexcept
+{
+	auto text = reinterpret_cast<const char *>(sqlite3_column_text(m_stmt, col));
+	if (!text)
+		return {};
+
+	return { text, static_cast<size_t>(sqlite3_column_bytes(m_stmt, col)) };
+}
+
+Select::ColumnView Select::RowView::column(int col) const noexcept
+{
+	switch (sqlite3_column_type(m_stmt, col)) {
+	case SQLITE_INTEGER: {
+		const auto val = getInt64(col);
+		if (std::in_range<int>(val))
+			return static_cast<int>(val);
+		return val;
+	}
+	case SQLITE_FLOAT:
+		return getDouble(col);
+	case SQLITE_TEXT:
+		return getText(col);
+	case SQLITE_BLOB:
+		return getBlob(col);
+	case SQLITE_NULL:
+	default:
+		return std::monostate();
+	}
+}
+
+Select::Select(const SQLConn &conn, const SQLStmtHolder &sel, const SQLConn::Binding &binding)
+	: m_conn(conn), m_resetter(sel), m_row(sel), m_started(false), m_done(false),
+	  m_failed(false)
+{
+	if (!conn.bind(sel, binding))
+		m_started = m_done = m_failed = true;
+}
+
+bool Select::step() noexcept
+{
+	m_started = true;
+	if (m_done)
+		return false;
+
+	auto ret = sqlite3_step(m_row.m_stmt);
+	if (ret == SQLITE_ROW)
+		return true;
+
+	m_done = true;
+	if (ret != SQLITE_DONE) {
+		m_conn.setError(ret, "db step (SELECT) failed", true);
+		m_failed = true;
+	}
+
+	return false;
+}
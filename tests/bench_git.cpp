@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+#include "git/Git.h"
+
+#include "helpers.h"
+
+using namespace SlGit;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr unsigned dirs = 100;
+constexpr unsigned filesPerDir = 1000;
+constexpr unsigned rounds = 5;
+
+template<typename F>
+std::chrono::microseconds best(F &&fun)
+{
+	auto min = std::chrono::microseconds::max();
+
+	for (auto i = 0U; i < rounds; ++i) {
+		const auto start = Clock::now();
+		fun();
+		const auto took = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+											start);
+		min = std::min(min, took);
+	}
+
+	return min;
+}
+
+void report(std::string_view what, std::chrono::microseconds took, size_t entries)
+{
+	std::cout << what << ": " << took.count() / 1000.0 << " ms (" <<
+		     took.count() * 1000.0 / entries << " ns/entry)\n";
+}
+
+/// @brief Create a tree of \c dirs directories with \c filesPerDir files each
+Tree createBigTree(const Repo &repo)
+{
+	const auto blob = repo.blobCreateFromBuffer("some content\n");
+	assert(blob);
+
+	auto topTb = repo.treeBuilderCreate();
+	assert(topTb);
+
+	for (auto d = 0U; d < dirs; ++d) {
+		auto dirTb = repo.treeBuilderCreate();
+		assert(dirTb);
+		for (auto f = 0U; f < filesPerDir; ++f)
+			assert(dirTb->insert("file_" + std::to_string(f) + ".patch", *blob));
+		const auto dirTree = dirTb->write(repo);
+		assert(dirTree);
+		assert(topTb->insert("dir_" + std::to_string(d), *dirTree));
+	}
+
+	auto tree = topTb->write(repo);
+	assert(tree);
+
+	return std::move(*tree);
+}
+
+void benchTreeWalk(const Repo &repo)
+{
+	const auto tree = createBigTree(repo);
+	const size_t entries = dirs * (filesPerDir + 1);
+
+	size_t count = 0, nameLen = 0;
+	const Tree::WalkCallback funCB = [&count, &nameLen](const std::string &root,
+							   const TreeEntry &entry) -> int {
+		count++;
+		nameLen += root.size() + entry.name().size();
+		return 0;
+	};
+	const auto funTook = best([&tree, &funCB]() {
+		assert(tree.walk(funCB));
+	});
+	assert(count == rounds * entries);
+
+	const auto funLen = nameLen;
+	count = nameLen = 0;
+	const auto templTook = best([&tree, &count, &nameLen]() {
+		assert(tree.walk([&count, &nameLen](std::string_view root,
+						    const TreeEntry &entry) -> int {
+			count++;
+			nameLen += root.size() + entry.nameSV().size();
+			return 0;
+		}));
+	});
+	assert(count == rounds * entries);
+	assert(nameLen == funLen);
+
+	report("Tree::walk(std::function)", funTook, entries);
+	report("Tree::walk(template)", templTook, entries);
+}
+
+void benchRevWalk(const Repo &repo)
+{
+	constexpr unsigned commits = 20000;
+
+	const auto me = Signature::now("Bench", "bench@example.com");
+	assert(me);
+	auto tb = repo.treeBuilderCreate();
+	assert(tb);
+	const auto tree = tb->write(repo);
+	assert(tree);
+
+	std::optional<Commit> parent;
+	for (auto i = 0U; i < commits; ++i) {
+		std::vector<const Commit *> parents;
+		if (parent)
+			parents.push_back(&*parent);
+		auto commit = repo.commitCreate(*me, *me, "commit " + std::to_string(i), *tree,
+						parents);
+		assert(commit);
+		parent.emplace(std::move(*commit));
+	}
+
+	size_t count = 0;
+	const auto walk = [&repo, &count](bool ids) {
+		return [&repo, &count, ids]() {
+			auto revWalk = repo.revWalkCreate();
+			assert(revWalk);
+			assert(revWalk->pushHead());
+			if (ids)
+				count += std::ranges::distance(revWalk->ids());
+			else
+				count += std::ranges::distance(revWalk->commits());
+		};
+	};
+
+	const auto commitsTook = best(walk(false));
+	const auto idsTook = best(walk(true));
+	assert(repo.commitGraphWrite());
+	const auto graphTook = best(walk(true));
+	assert(count == 3 * rounds * commits);
+
+	report("RevWalk::commits()", commitsTook, commits);
+	report("RevWalk::ids()", idsTook, commits);
+	report("RevWalk::ids() with commit-graph", graphTook, commits);
+}
+
+} // namespace
+
+int main()
+{
+	const auto gitDir = THelpers::getTmpDir("benchgitdir");
+	auto repo = Repo::init(gitDir, true);
+	assert(repo);
+
+	benchTreeWalk(*repo);
+	benchRevWalk(*repo);
+
+	std::filesystem::remove_all(gitDir);
+
+	return 0;
+}
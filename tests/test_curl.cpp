@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "curl/Curl.h"
+#include "curl/MultiCurl.h"
 
 #include "helpers.h"
 
@@ -44,6 +45,15 @@ void test_download(const std::string &url, const std::string &content)
 		assert(contentOpt);
 	}
 
+	{
+		LibCurl c;
+		const auto contentOpt = c.download("https://www.google.com", &resp);
+		assert(resp >= 200 && resp < 400);
+		assert(contentOpt);
+		assert(c.lastTransfer().uncompressedBytes == contentOpt->size());
+		assert(c.lastTransfer().compressedBytes < c.lastTransfer().uncompressedBytes);
+	}
+
 	{
 		const auto contentOpt = LibCurl::singleDownload("https://www.google.com", &resp);
 		assert(resp >= 200 && resp < 400);
@@ -80,6 +90,78 @@ void test_download(const std::string &url, const std::string &content)
 	}
 }
 
+void test_downloadStreaming(const std::string &url, const std::string &content)
+{
+	LibCurl c;
+	{
+		std::string str("prefix");
+		assert(c.downloadToString(url, str));
+		assert(str == "prefix" + content);
+		assert(c.lastTransfer().uncompressedBytes == content.size());
+		assert(c.lastTransfer().compressedBytes == content.size());
+	}
+	{
+		std::ostringstream ss;
+		assert(c.downloadToStream(url, ss));
+		assert(ss.str() == content);
+	}
+	{
+		std::string str;
+		assert(c.downloadChunks(url, [&str](std::string_view chunk) {
+			str.append(chunk);
+			return true;
+		}));
+		assert(str == content);
+	}
+	{
+		assert(!c.downloadChunks(url, [](std::string_view) { return false; }));
+		std::cerr << __func__ << ": EXPECTED error: " << LibCurl::lastError() << '\n';
+	}
+}
+
+void test_retry(const std::string &url, const std::string &content)
+{
+	std::vector<std::pair<bool, unsigned>> attempts;
+	LibCurl c;
+	c.setRetryPolicy({ .maxRetries = 2, .initialDelay = std::chrono::milliseconds(1),
+			   .maxDelay = std::chrono::milliseconds(2), .jitter = false });
+	c.setObserver([&attempts](const std::string &, bool success, const TransferInfo &info) {
+		attempts.emplace_back(success, info.attempt);
+	});
+
+	std::string str;
+	assert(c.downloadToString(url, str));
+	assert(str == content);
+	assert(attempts.size() == 1 && attempts.back().first && attempts.back().second == 1);
+
+	/* not transient, no retries */
+	attempts.clear();
+	assert(!c.downloadToString(url + "_nonexistent", str));
+	assert(attempts.size() == 1 && !attempts.back().first);
+
+	attempts.clear();
+	assert(!c.downloadToString("http://nonexistent.invalid/", str));
+	std::cerr << __func__ << ": EXPECTED error: " << LibCurl::lastError() << '\n';
+	assert(attempts.size() == 3 && attempts.back().second == 3);
+
+	attempts.clear();
+	MultiCurl multi;
+	multi.setRetryPolicy({ .maxRetries = 1, .initialDelay = std::chrono::milliseconds(1) });
+	multi.setObserver([&attempts](const std::string &, bool success, const TransferInfo &info) {
+		attempts.emplace_back(success, info.attempt);
+	});
+	multi.add("http://nonexistent.invalid/", [](MultiCurl::Result &&res) {
+		assert(!res.success);
+		assert(res.info.attempt == 2);
+	});
+	multi.add(url, [&content](MultiCurl::Result &&res) {
+		assert(res.success);
+		assert(res.content == content);
+	});
+	assert(!multi.perform());
+	assert(attempts.size() == 3);
+}
+
 void test_downloadToFile(const std::filesystem::path &tmpDir, const std::string &url,
 			 const std::string &content)
 {
@@ -92,9 +174,86 @@ void test_downloadToFile(const std::filesystem::path &tmpDir, const std::string
 	std::ostringstream oss;
 	oss << ifs.rdbuf();
 	assert(oss.str() == content);
+
+	assert(!LibCurl::singleDownloadToFile(url, tmpDir / "nonexistent" / "file"));
+	std::cerr << __func__ << ": EXPECTED error: " << LibCurl::lastError() << '\n';
+	assert(LibCurl::lastError().find("cannot open") != std::string::npos);
 }
 
 
+void test_multi(const std::filesystem::path &tmpDir, const std::string &url,
+		const std::string &content)
+{
+	MultiCurl multi(2);
+	std::vector<std::string> urls;
+	for (auto i = 0U; i < 5; ++i) {
+		const auto file = tmpDir / ("multi" + std::to_string(i));
+		writeContentToFile(file, content + std::to_string(i));
+		urls.push_back("file://" + file.string());
+	}
+
+	unsigned done = 0;
+	for (auto i = 0U; i < urls.size(); ++i)
+		multi.add(urls[i], [&content, &urls, &done, i](MultiCurl::Result &&res) {
+			assert(res.success);
+			assert(res.url == urls[i]);
+			assert(res.content == content + std::to_string(i));
+			assert(res.info.uncompressedBytes == res.content.size());
+			done++;
+		});
+	assert(multi.perform());
+	assert(done == urls.size());
+
+	done = 0;
+	multi.add("file:///012345test", [&done](MultiCurl::Result &&res) {
+		std::cerr << __func__ << ": EXPECTED error: " << res.error << '\n';
+		assert(!res.success);
+		assert(!res.error.empty());
+		done++;
+	});
+	multi.add(url, [&content, &done](MultiCurl::Result &&res) {
+		assert(res.success);
+		assert(res.content == content);
+		done++;
+	});
+	assert(!multi.perform());
+	assert(done == 2);
+
+	const auto contentOpt = multi.download(url);
+	assert(contentOpt);
+	assert(*contentOpt == content);
+
+	done = 0;
+	const auto destFile = tmpDir / (std::string(__func__) + "_dest");
+	std::string chunks;
+	multi.add(url, destFile, [&done](MultiCurl::Result &&res) {
+		assert(res.success);
+		assert(res.content.empty());
+		done++;
+	});
+	multi.add(url, [&chunks](std::string_view chunk) {
+		chunks.append(chunk);
+		return true;
+	}, [&done](MultiCurl::Result &&res) {
+		assert(res.success);
+		done++;
+	});
+	multi.add(url, tmpDir / "nonexistent" / "file", [&done](MultiCurl::Result &&res) {
+		std::cerr << __func__ << ": EXPECTED error: " << res.error << '\n';
+		assert(!res.success);
+		done++;
+	});
+	assert(!multi.perform());
+	assert(done == 3);
+	assert(chunks == content);
+
+	std::ifstream ifs(destFile, std::ios::in | std::ios::binary);
+	assert(ifs);
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	assert(oss.str() == content);
+}
+
 void test_isDownloadNeeded(const std::filesystem::path &tmpDir)
 {
 	std::filesystem::path tmp_file = tmpDir / __func__;
@@ -117,6 +276,49 @@ void test_isDownloadNeeded(const std::filesystem::path &tmpDir)
 	assert(!LibCurl::isDownloadNeeded(tmp_file, exists, false, 3h));
 }
 
+void test_fetchFilesIfNeeded(const std::filesystem::path &tmpDir, const std::string &url,
+			     const std::string &content)
+{
+	const auto fresh = tmpDir / "fetchFresh";
+	const auto old = tmpDir / "fetchOld";
+	const auto stale = tmpDir / "fetchStale";
+	writeContentToFile(fresh, "fresh");
+	writeContentToFile(old, "old");
+	writeContentToFile(stale, "stale");
+	std::filesystem::last_write_time(old,
+					 std::filesystem::file_time_type::clock::now() - 2h);
+	std::filesystem::last_write_time(stale,
+					 std::filesystem::file_time_type::clock::now() - 2h);
+
+	const std::vector<LibCurl::FetchEntry> files {
+		{ fresh, url, 1h },
+		{ old, url, 1h },
+		{ tmpDir / "fetchNew", url, 1h },
+		{ stale, "file:///012345test", 1h },
+		{ tmpDir / "fetchFailed", "file:///012345test", 1h },
+	};
+
+	auto ret = LibCurl::fetchFilesIfNeeded(files, false, false, 2);
+	assert(ret.size() == files.size());
+	assert(ret[0] == LibCurl::FetchStatus::FRESH);
+	assert(ret[1] == LibCurl::FetchStatus::DOWNLOADED);
+	assert(ret[2] == LibCurl::FetchStatus::DOWNLOADED);
+	assert(ret[3] == LibCurl::FetchStatus::STALE);
+	assert(ret[4] == LibCurl::FetchStatus::FAILED);
+
+	std::ifstream ifs(old, std::ios::in | std::ios::binary);
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	assert(oss.str() == content);
+	assert(std::filesystem::exists(tmpDir / "fetchNew"));
+	assert(!std::filesystem::exists(tmpDir / "fetchFailed"));
+
+	ret = LibCurl::fetchFilesIfNeeded(files, false, true);
+	assert(ret[0] == LibCurl::FetchStatus::FRESH);
+	assert(ret[1] == LibCurl::FetchStatus::FRESH);
+	assert(ret[3] == LibCurl::FetchStatus::FAILED);
+}
+
 void test_fetchFileIfNeeded()
 {
 	if (!HAS_CONNECTION)
@@ -139,9 +341,13 @@ int main()
 	const auto content = writeContentToFile(file, "test\nfile\n");
 
 	test_download(url, content);
+	test_downloadStreaming(url, content);
+	test_retry(url, content);
 	test_downloadToFile(tmpDir, url, content);
+	test_multi(tmpDir, url, content);
 
 	test_isDownloadNeeded(tmpDir);
+	test_fetchFilesIfNeeded(tmpDir, url, content);
 	test_fetchFileIfNeeded();
 
 	std::filesystem::remove_all(tmpDir);
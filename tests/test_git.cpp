@@ -1,8 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 #include "git/Git.h"
 
@@ -208,6 +212,66 @@ void testDiff(const SlGit::Repo &repo, const SlGit::Commit &aCommit, const SlGit
 	}
 }
 
+void testTreeChanges(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
+		     const SlGit::Commit &bCommit, const std::filesystem::path &aFile,
+		     const std::filesystem::path &bFile)
+{
+	static_assert(std::random_access_iterator<SlGit::TreeChanges::iterator>);
+	static_assert(std::ranges::random_access_range<SlGit::TreeChanges>);
+
+	{
+		auto changes = SlGit::TreeChanges::create(repo, aCommit, bCommit);
+		assert(changes);
+		assert(changes->size() == 1);
+		const auto change = (*changes)[0];
+		assert(change.status == GIT_DELTA_ADDED);
+		assert(change.newPath == bFile);
+		assert(git_oid_is_zero(&change.oldId));
+		assert(std::distance(changes->begin(), changes->end()) == 1);
+	}
+	{
+		auto changes = SlGit::TreeChanges::create(repo, bCommit, aCommit,
+							  { .pathSpec = { aFile.string() } });
+		assert(changes);
+		assert(changes->empty());
+		assert(changes->begin() == changes->end());
+	}
+	{
+		auto aTree = aCommit.tree();
+		auto changes = SlGit::TreeChanges::create(repo, nullptr, &*aTree);
+		assert(changes);
+		assert(changes->size() == 1);
+		assert((*changes)[0].newPath == aFile);
+	}
+	{
+		auto bTree = bCommit.tree();
+		auto tb = repo.treeBuilderCreate(&*bTree);
+		assert(tb);
+		auto bBlob = repo.blobLookup(*bTree->treeEntryByPath(bFile));
+		assert(bBlob);
+		assert(tb->remove(bFile));
+		assert(tb->insert("c.txt", *bBlob));
+		auto cTree = tb->write(repo);
+		assert(cTree);
+
+		auto changes = SlGit::TreeChanges::create(repo, &*bTree, &*cTree);
+		assert(changes);
+		assert(changes->size() == 2);
+
+		changes = SlGit::TreeChanges::create(repo, &*bTree, &*cTree, { .renames = true });
+		assert(changes);
+		assert(changes->size() == 1);
+		for (const auto &change : *changes) {
+			std::cout << __func__ << ": " << change.oldPath << " -> " << change.newPath <<
+				     " similarity=" << change.similarity << '\n';
+			assert(change.status == GIT_DELTA_RENAMED);
+			assert(change.oldPath == bFile);
+			assert(change.newPath == "c.txt");
+			assert(git_oid_equal(&change.oldId, &change.newId));
+		}
+	}
+}
+
 void testDiffBuffer()
 {
 	{
@@ -383,6 +447,50 @@ void testRevWalk(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
 	nextCommit = revWalk->next();
 	assert(!nextCommit);
 	assert(repo.lastErrno() == GIT_ITEROVER);
+
+	{
+		auto revWalk = repo.revWalkCreate();
+		assert(revWalk);
+		assert(revWalk->pushHead());
+		auto nextId = revWalk->nextId();
+		assert(nextId);
+		assert(git_oid_equal(&*nextId, bCommit.id()));
+
+		std::vector<git_oid> ids;
+		for (const auto &oid : revWalk->ids())
+			ids.push_back(oid);
+		assert(ids.size() == 1);
+		assert(git_oid_equal(&ids[0], aCommit.id()));
+		assert(repo.lastErrno() == GIT_ITEROVER);
+	}
+
+	assert(!repo.hasCommitGraph());
+	assert(repo.commitGraphWrite());
+	assert(repo.hasCommitGraph());
+
+	{
+		auto revWalk = repo.revWalkCreate();
+		assert(revWalk);
+		assert(revWalk->pushHead());
+		std::vector<std::string> shas;
+		for (const auto &commit : revWalk->commits())
+			shas.push_back(commit.idStr());
+		assert((shas == std::vector<std::string> { bCommit.idStr(), aCommit.idStr() }));
+	}
+	{
+		auto revWalk = repo.revWalkCreate();
+		assert(revWalk);
+		assert(revWalk->pushHead());
+		assert(revWalk->hideOlderThan(bCommit.time() + 1));
+		assert(revWalk->ids().begin() == std::default_sentinel);
+	}
+	{
+		auto revWalk = repo.revWalkCreate();
+		assert(revWalk);
+		assert(revWalk->pushHead());
+		assert(revWalk->hideOlderThan(aCommit.time()));
+		assert(std::ranges::distance(revWalk->ids()) == 2);
+	}
 }
 
 void testCatFile(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
@@ -399,6 +507,167 @@ void testCatFile(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
 	auto bContentRead = repo.catFile("HEAD", bFile);
 	assert(bContentRead);
 	assert(bContent == *bContentRead);
+
+	std::optional<SlGit::BlobView> view;
+	{
+		auto tmp = repo.catFileView("HEAD", bFile);
+		assert(tmp);
+		view.emplace(std::move(*tmp));
+	}
+	assert(view->view() == bContent);
+	assert(view->size() == bContent.size());
+	assert(std::string_view(*view) == std::string_view(view->blob().contentView()));
+	assert(view->data() == view->blob().contentView().data());
+
+	auto aView = aCommit.catFileView(aFile);
+	assert(aView);
+	assert(aView->view() == aContent);
+	assert(!aCommit.catFileView(bFile));
+	assert(!repo.catFileView("nonexistent", bFile));
+}
+
+void testTreeWalk(const SlGit::Repo &repo, const SlGit::Commit &bCommit,
+		  const std::filesystem::path &aFile, const std::filesystem::path &bFile)
+{
+	auto tb = repo.treeBuilderCreate();
+	assert(tb);
+	assert(tb->insert("dir", *bCommit.tree()));
+	auto tree = tb->write(repo);
+	assert(tree);
+
+	std::vector<std::string> seen;
+	assert(tree->walk([&seen](std::string_view root, const SlGit::TreeEntry &entry) -> int {
+		seen.push_back(std::string(root).append(entry.nameSV()));
+		return 0;
+	}));
+	assert((seen == std::vector<std::string> { "dir", "dir/" + aFile.string(),
+						   "dir/" + bFile.string() }));
+
+	seen.clear();
+	assert(tree->walk([&seen](const std::string &root, const SlGit::TreeEntry &entry) -> int {
+		seen.push_back(root + entry.name());
+		return 0;
+	}));
+	assert(seen.size() == 3);
+
+	unsigned calls = 0;
+	assert(!tree->walk([&calls](std::string_view, const SlGit::TreeEntry &) -> int {
+		return ++calls == 2 ? -1 : 0;
+	}));
+	assert(calls == 2);
+}
+
+void testTreeScan(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
+		  const SlGit::Commit &bCommit, const std::filesystem::path &aFile,
+		  const std::string &aContent, const std::filesystem::path &bFile,
+		  const std::string &bContent)
+{
+	SlGit::TreeScan scan(repo, 2);
+	assert(scan.enumerate(*bCommit.tree()));
+	assert(scan.entries().size() == 2);
+	assert(scan.entries()[0].path == aFile);
+	assert(scan.entries()[1].path == bFile);
+	assert(scan.entries()[0].mode == GIT_FILEMODE_BLOB);
+	assert(scan.enumerate(*aCommit.tree()));
+	assert(scan.entries().size() == 3);
+
+	std::vector<std::string> merged;
+	const auto map = [](const SlGit::Repo &, const SlGit::TreeScan::Entry &entry,
+			    std::string_view content) {
+		return entry.path + ':' + std::string(content);
+	};
+	const auto merge = [&merged](const SlGit::TreeScan::Entry &, std::string &&res) {
+		merged.push_back(std::move(res));
+	};
+	assert(scan.forEachBlob(map, merge));
+	assert((merged == std::vector<std::string> {
+		aFile.string() + ':' + aContent,
+		bFile.string() + ':' + bContent,
+		aFile.string() + ':' + aContent,
+	}));
+
+	merged.clear();
+	assert(scan.forEachBlob(map, merge, SlGit::TreeScan::Order::UNORDERED));
+	std::sort(merged.begin(), merged.end());
+	assert(merged.size() == 3);
+	assert(merged[2] == bFile.string() + ':' + bContent);
+
+	assert(!scan.forEachBlob([](const SlGit::Repo &, const SlGit::TreeScan::Entry &,
+				    std::string_view) -> int {
+		throw std::runtime_error("map failed");
+	}, [](const SlGit::TreeScan::Entry &, int) {}));
+	assert(scan.lastError() == "map failed");
+
+	scan.clear();
+	assert(!scan.enumerate(*bCommit.tree(), bFile));
+	std::cerr << __func__ << ": EXPECTED error: " << scan.lastError() << '\n';
+	assert(scan.entries().empty());
+}
+
+void testRepoPool(const SlGit::Repo &repo, const SlGit::Commit &aCommit)
+{
+	assert(SlGit::RepoPool::setCacheLimits({ .maxSize = 64 << 20, .blobLimit = 4096 }));
+	const auto cache = SlGit::RepoPool::cacheStats();
+	assert(cache);
+	assert(cache->allowed == 64 << 20);
+
+	SlGit::RepoPool pool(repo.path());
+	const auto r1 = pool.get();
+	assert(r1);
+	assert(pool.get() == r1);
+	assert(r1->commitLookup(*aCommit.id()) == aCommit);
+
+	const SlGit::Repo *r2 = nullptr;
+	std::thread([&pool, &r2, &aCommit]() {
+		r2 = pool.get();
+		assert(r2);
+		assert(r2->commitLookup(*aCommit.id()));
+	}).join();
+	assert(r2 && r2 != r1);
+
+	auto stats = pool.stats();
+	assert(stats.opened == 2);
+	assert(stats.gets == 3);
+	assert(stats.cache.allowed == 64 << 20);
+
+	pool.release();
+	assert(pool.stats().opened == 1);
+
+	SlGit::RepoPool badPool("/nonexistent/repo");
+	assert(!badPool.get());
+	std::cerr << __func__ << ": EXPECTED error: " << SlGit::Repo::lastError() << '\n';
+}
+
+void testCatFiles(const SlGit::Repo &repo, const std::filesystem::path &aFile,
+		  const std::string &aContent, const std::filesystem::path &bFile,
+		  const std::string &bContent)
+{
+	SlGit::CatFiles cat(repo);
+	const auto aInA = cat.add("aRef", aFile);
+	const auto aInB = cat.add("bRef", aFile);
+	const auto bInB = cat.add("bRef", bFile);
+	const auto bInA = cat.add("aRef", bFile);
+	const auto bInHead = cat.add("HEAD", "/" + bFile.string());
+	const auto aInBad = cat.add("nonexistent", aFile);
+	const auto dirInB = cat.add("bRef", aFile.string() + "/x");
+	assert(cat.size() == 7);
+	assert(cat.run());
+
+	assert(cat.content(aInA) == aContent);
+	assert(cat.content(aInB) == aContent);
+	assert(cat.blob(aInA) == cat.blob(aInB));
+	assert(cat.content(bInB) == bContent);
+	assert(cat.content(bInHead) == bContent);
+	assert(!cat.content(bInA));
+	assert(!cat.content(aInBad));
+	assert(!cat.content(dirInB));
+
+	const auto &stats = cat.stats();
+	std::cout << __func__ << ": revs=" << stats.revs << " trees=" << stats.trees <<
+		     " blobs=" << stats.blobs << '\n';
+	assert(stats.revs == 4);
+	assert(stats.trees == 2);
+	assert(stats.blobs == 2);
 }
 
 void testFilesOnFS(const SlGit::Repo &repo, const std::filesystem::path &aFile,
@@ -443,6 +712,130 @@ void testFetch(const SlGit::Repo &repo2, const SlGit::Commit &bCommit)
 	assert(originMaster == bCommit);
 }
 
+void testFetchOptions(const SlGit::Repo &repo, const SlGit::Repo &repo2,
+		      const SlGit::Commit &bCommit)
+{
+	assert(repo.refCreateDirect("refs/heads/gone", *bCommit.id()));
+
+	auto remote = repo2.remoteLookup("origin");
+	assert(remote);
+	SlGit::DefaultFetchCallbacks fc;
+	assert(remote->fetchRefspecs(fc, {}, { .tags = false }));
+	assert(repo2.refLookup("refs/remotes/origin/gone"));
+
+	{
+		auto ref = repo.refLookup("refs/heads/gone");
+		assert(ref);
+		assert(!git_reference_delete(*ref));
+	}
+
+	assert(remote->fetchRefspecs(fc, {}, { .tags = false }));
+	assert(repo2.refLookup("refs/remotes/origin/gone"));
+	assert(remote->fetchRefspecs(fc, {}, { .tags = false, .prune = true }));
+	assert(!repo2.refLookup("refs/remotes/origin/gone"));
+}
+
+void testCloneOptions(const SlGit::Repo &repo, const SlGit::Commit &bCommit,
+		      const std::filesystem::path &aFile)
+{
+	SlGit::DefaultFetchCallbacks fc;
+	{
+		const auto gitDir = THelpers::getTmpDir("testgitdir3");
+		auto bare = SlGit::Repo::clone(gitDir, repo.path(), fc,
+					       { .tags = false, .bare = true,
+						 .local = GIT_CLONE_LOCAL_NO_LINKS });
+		assert(bare);
+		assert(bare->isBare());
+		assert(bare->commitHead() == bCommit);
+		std::filesystem::remove_all(gitDir);
+	}
+	{
+		const auto gitDir = THelpers::getTmpDir("testgitdir4");
+		auto noCheckout = SlGit::Repo::clone(gitDir, repo.path(), fc,
+						     { .checkout = false });
+		assert(noCheckout);
+		assert(!noCheckout->isBare());
+		assert(noCheckout->commitHead() == bCommit);
+		assert(!std::filesystem::exists(gitDir / aFile));
+		std::filesystem::remove_all(gitDir);
+	}
+}
+
+void testMetricsFetchCallbacks()
+{
+	SlGit::MetricsFetchCallbacks fc(false, std::chrono::hours(1));
+	git_indexer_progress stats{};
+
+	stats.total_objects = 10;
+	stats.received_objects = stats.indexed_objects = 5;
+	stats.received_bytes = 500;
+	assert(!fc.transferProgress(stats));
+	stats.received_objects = stats.indexed_objects = 6;
+	assert(!fc.transferProgress(stats));
+	assert(fc.samples().size() == 1);
+
+	stats.received_objects = stats.indexed_objects = 10;
+	stats.received_bytes = 1000;
+	stats.total_deltas = 4;
+	assert(!fc.transferProgress(stats));
+	stats.indexed_deltas = 4;
+	assert(!fc.transferProgress(stats));
+
+	const auto &samples = fc.samples();
+	assert(samples.size() == 3);
+	assert(samples[0].phase == SlGit::MetricsFetchCallbacks::Phase::RECEIVING);
+	assert(samples[0].receivedObjects == 5);
+	assert(samples[1].phase == SlGit::MetricsFetchCallbacks::Phase::RESOLVING);
+	assert(samples[2].indexedDeltas == 4);
+	assert(samples[0].at <= samples[2].at);
+
+	const auto sum = fc.summary();
+	assert(sum.objects == 10);
+	assert(sum.deltas == 4);
+	assert(sum.bytes == 1000);
+	assert(sum.receiving + sum.resolving <= sum.total + std::chrono::milliseconds(1));
+
+	fc.reset();
+	assert(fc.samples().empty());
+	assert(fc.summary().bytes == 0);
+}
+
+void testUpdater(const SlGit::Repo &repo, const SlGit::Repo &repo2)
+{
+	const auto gitDir = THelpers::getTmpDir("testgitdir5");
+	{
+		SlGit::DefaultFetchCallbacks fc;
+		assert(SlGit::Repo::clone(gitDir, "file://" + repo.path().string(), fc,
+					  { .bare = true }));
+	}
+
+	SlGit::Updater updater(2);
+	updater.add(repo2.workDir());
+	updater.add(gitDir);
+	updater.add(repo2.workDir(), "nonexistent");
+	assert(updater.size() == 3);
+
+	const auto results = updater.run(false);
+	assert(results.size() == 3);
+	assert(results[0].ok);
+	assert(results[1].ok);
+	assert(results[1].path == gitDir);
+	assert(!results[2].ok);
+	assert(results[2].remote == "nonexistent");
+	assert(!results[2].error.empty());
+
+	std::ostringstream report;
+	SlGit::Updater::report(report, results);
+	const auto str = report.str();
+	assert(std::ranges::count(str, '\n') == 4);
+	assert(str.find(gitDir.string() + " origin: ") != std::string::npos);
+	assert(str.find(" nonexistent: FAILED (" + results[2].error + ')') != std::string::npos);
+	assert(str.find("\nTotal: ") != std::string::npos);
+	assert(str.find(" from 3 remotes") != std::string::npos);
+
+	std::filesystem::remove_all(gitDir);
+}
+
 void testPathSpec(const SlGit::Repo &repo, const SlGit::Commit &aCommit,
 		  const SlGit::Commit &bCommit)
 {
@@ -522,15 +915,24 @@ int main()
 	auto [ bCommit, bFile, bContent ] = createBCommit(repo, aCommit, me);
 	testOperator(aCommit, bCommit);
 	testDiff(repo, aCommit, bCommit);
+	testTreeChanges(repo, aCommit, bCommit, aFile, bFile);
 	testDiffBuffer();
 	testTags(repo, aCommit, bCommit, me);
 	testRevparse(repo, aCommit, bCommit, bFile);
 	testRemote(repo);
 	testRevWalk(repo, aCommit, bCommit);
 	testCatFile(repo, aCommit, aFile, aContent, bFile, bContent);
+	testTreeWalk(repo, bCommit, aFile, bFile);
+	testTreeScan(repo, aCommit, bCommit, aFile, aContent, bFile, bContent);
+	testRepoPool(repo, aCommit);
+	testCatFiles(repo, aFile, aContent, bFile, bContent);
 	testFilesOnFS(repo, aFile, aContent, bFile);
 	testCheckout(repo2, aCommit);
 	testFetch(repo2, bCommit);
+	testFetchOptions(repo, repo2, bCommit);
+	testCloneOptions(repo, bCommit, aFile);
+	testMetricsFetchCallbacks();
+	testUpdater(repo, repo2);
 	testPathSpec(repo, aCommit, bCommit);
 	testIndex(repo, aCommit, bCommit);
 
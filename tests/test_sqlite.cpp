@@ -1,12 +1,18 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <iostream>
 #include <optional>
 #include <sqlite3.h>
+#include <thread>
 
 #include "helpers/Color.h"
 #include "sqlite/SQLConn.h"
+#include "sqlite/SQLConnPool.h"
+#include "sqlite/SQLWriter.h"
+#include "sqlite/Select.h"
 
 #include "helpers.h"
 
@@ -46,6 +52,12 @@ public:
 				"age INTEGER NOT NULL",
 				"address INTEGER NOT NULL REFERENCES address(id)",
 			}},
+			{ "object", {
+				"id INTEGER PRIMARY KEY",
+				"oid BLOB NOT NULL UNIQUE",
+				"size INTEGER NOT NULL",
+				"ratio REAL",
+			}},
 			{ "personTemp", {
 				"id INTEGER PRIMARY KEY",
 				"name TEXT NOT NULL",
@@ -55,11 +67,15 @@ public:
 			}, TABLE_TEMPORARY },
 		};
 
-		return createTables(create_tables);
+		static const Indices indices {
+			{ "person_age_index", "person(age)" },
+		};
+
+		return createTables(create_tables) && createIndices(indices);
 	}
 
 	virtual bool prepDB() override {
-		static const Statements stmts {
+		const Statements stmts {
 			{ insAddress, "INSERT INTO address(street) VALUES (:street);" },
 			{ insPerson, "INSERT INTO person(name, age, address) "
 				     "SELECT :name, :age, address.id "
@@ -73,6 +89,18 @@ public:
 					"SELECT personTemp.name, personTemp.age, address.id "
 					"FROM personTemp "
 					"JOIN address ON personTemp.street = address.street;" },
+			{ insPersonTyped, "INSERT INTO person(name, age, address) "
+					  "SELECT :name, :age, address.id "
+					  "FROM address "
+					  "WHERE address.street = :street;" },
+			{ selPersonTyped, "SELECT person.name, age "
+					  "FROM person "
+					  "WHERE person.name LIKE :name AND age >= :age "
+					  "ORDER BY person.id;" },
+			{ badPersonTyped, "SELECT 1 FROM person WHERE name = :name;" },
+			{ insObject, "INSERT INTO object(oid, size, ratio) "
+				     "VALUES (:oid, :size, :ratio);" },
+			{ selObject, "SELECT oid, size, ratio FROM object WHERE oid = :oid;" },
 			{ delPerson, "DELETE FROM person;" },
 			{ selPerson, "SELECT person.name, age, address.street "
 				     "FROM person "
@@ -123,6 +151,92 @@ public:
 		return select(selPerson, { { ":name", name } });
 	}
 
+	bool insertPersonTyped(std::string_view name, const int age,
+			       const std::optional<std::string> &street,
+			       uint64_t *affected = nullptr) const {
+		return insert(insPersonTyped, { name, age, street }, affected);
+	}
+
+	std::optional<SlSqlite::SQLConn::SelectResult>
+	getPersonsTyped(std::string_view name, unsigned minAge) const {
+		return select(selPersonTyped, { name, minAge });
+	}
+
+	template <typename Range>
+	bool insertAddresses(const Range &streets, BatchResult *result, int maxVars = -1) {
+		if (maxVars > 0)
+			sqlite3_limit(sqlHolder, SQLITE_LIMIT_VARIABLE_NUMBER, maxVars);
+		return insertBatch("INSERT INTO address(street)", streets, result);
+	}
+
+	bool hasStreet(std::string_view street) const {
+		SlSqlite::SQLStmtHolder sel;
+		assert(prepareStatement("SELECT 1 FROM address WHERE street = :street;", sel));
+		auto res = select(sel, { { ":street", street } });
+		return res && !res->empty();
+	}
+
+	bool countTo(int n) const {
+		SlSqlite::SQLStmtHolder sel;
+		assert(prepareStatement("WITH RECURSIVE c(x) AS "
+					"(SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < :n) "
+					"SELECT count(*) FROM c;", sel));
+		auto res = select(sel, { { ":n", n } });
+		return res && res->size() == 1;
+	}
+
+	std::string journalMode() const {
+		SlSqlite::SQLStmtHolder sel;
+		assert(prepareStatement("PRAGMA journal_mode;", sel));
+		auto res = select(sel, {});
+		assert(res && res->size() == 1);
+		return std::get<std::string>(res->front().front());
+	}
+
+	int synchronous() const {
+		SlSqlite::SQLStmtHolder sel;
+		assert(prepareStatement("PRAGMA synchronous;", sel));
+		auto res = select(sel, {});
+		assert(res && res->size() == 1);
+		return std::get<int>(res->front().front());
+	}
+
+	bool hasIndex(std::string_view name) const {
+		SlSqlite::SQLStmtHolder sel;
+		assert(prepareStatement("SELECT 1 FROM sqlite_master "
+					"WHERE type = 'index' AND name = :name;", sel));
+		auto res = select(sel, { { ":name", name } });
+		return res && !res->empty();
+	}
+
+	bool insertObject(Blob oid, int64_t size, std::optional<double> ratio) const {
+		return insert(insObject, { oid, size, ratio });
+	}
+
+	std::optional<SlSqlite::SQLConn::SelectResult> getObject(Blob oid) const {
+		return select(selObject, { { ":oid", oid } });
+	}
+
+	bool badTyped() const {
+		return insert(badPersonTyped, { "name", 1 });
+	}
+
+	template <typename CB>
+	bool forEachPerson(std::string_view name, const CB &cb) const {
+		Select sel(*this, selPerson, { { ":name", name } });
+		for (const auto &row : sel)
+			if (!cb(row))
+				break;
+		return !sel.failed();
+	}
+
+	bool badSelect() const {
+		Select sel(*this, selPerson, { { ":nameFoo", std::string_view() } });
+		for (const auto &row : sel)
+			(void)row;
+		return !sel.failed();
+	}
+
 	bool delPersons(uint64_t *affected = nullptr) const {
 		return insert(delPerson, {}, affected);
 	}
@@ -137,6 +251,11 @@ private:
 	SlSqlite::SQLStmtHolder movePerson;
 	SlSqlite::SQLStmtHolder selPerson;
 	SlSqlite::SQLStmtHolder delPerson;
+	SlSqlite::TypedStmtHolder<std::string_view, int, std::optional<std::string>> insPersonTyped;
+	SlSqlite::TypedStmtHolder<std::string_view, unsigned> selPersonTyped;
+	SlSqlite::TypedStmtHolder<std::string_view, int> badPersonTyped;
+	SlSqlite::TypedStmtHolder<Blob, int64_t, std::optional<double>> insObject;
+	SlSqlite::SQLStmtHolder selObject;
 };
 
 
@@ -277,6 +396,355 @@ void testSelect(const SQLConn &db)
 	}
 }
 
+void testTyped(const SQLConn &db)
+{
+	uint64_t affected = ~0ULL;
+	assert(db.insertPersonTyped("Jim Typed", 40, std::string(people[0].addr), &affected));
+	assert(affected == 1);
+	persons += affected;
+
+	affected = ~0ULL;
+	assert(db.insertPersonTyped("Jim Null", 40, std::nullopt, &affected));
+	assert(affected == 0);
+
+	auto resOpt = db.getPersonsTyped("Jim%", 30);
+	assert(resOpt);
+	assert(resOpt->size() == 1);
+	assert(std::get<std::string>((*resOpt)[0][0]) == "Jim Typed");
+	assert(std::get<int>((*resOpt)[0][1]) == 40);
+
+	resOpt = db.getPersonsTyped("Jim%", 41);
+	assert(resOpt && resOpt->empty());
+
+	assert(!db.badTyped());
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << db.lastError();
+	assert(db.lastError().find("expects 1 parameters, got 2") != std::string::npos);
+}
+
+void testBatch(const std::filesystem::path &tmpDir)
+{
+	SQLConn db;
+	assert(db.open(tmpDir / "batch.db", OpenFlags::CREATE));
+
+	std::vector<std::tuple<std::string>> streets;
+	for (auto i = 0; i < 10; ++i)
+		streets.emplace_back("Batch street " + std::to_string(i));
+
+	SQLConn::BatchResult res;
+	assert(db.enableProfiling());
+	assert(db.insertAddresses(streets, &res, 4));
+	assert(res.affected == 10);
+	assert(res.uniqueConflicts == 0);
+	db.disableProfiling();
+	const auto prof = db.profile();
+	/* 4 + 4 + 2 rows, the last 2 in one statement too */
+	assert(std::ranges::count_if(prof, [](const SQLConn::StmtProfile &p) {
+		return p.sql.starts_with("INSERT INTO address");
+	}) == 2);
+	assert(std::ranges::any_of(prof, [](const SQLConn::StmtProfile &p) {
+		return p.sql == "INSERT INTO address(street) VALUES (?), (?);" && p.calls == 1;
+	}));
+
+	streets.emplace_back("Batch street 10");
+	assert(db.insertAddresses(streets, &res));
+	assert(res.affected == 1);
+	assert(res.uniqueConflicts == 10);
+
+	std::vector<std::tuple<std::optional<std::string>>> bad;
+	for (auto i = 0; i < 5; ++i)
+		bad.emplace_back("Rollback street " + std::to_string(i));
+	bad.emplace_back(std::nullopt);
+	assert(!db.insertAddresses(bad, &res, 4));
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << db.lastError();
+	assert(!db.hasStreet("Rollback street 0"));
+	assert(!db.inTransaction());
+}
+
+void testBulkLoad(const std::filesystem::path &tmpDir)
+{
+	SQLConn db;
+	assert(db.open(tmpDir / "bulk.db", OpenFlags::CREATE | OpenFlags::BULK_LOAD));
+	assert(!db.hasIndex("person_age_index"));
+	assert(db.journalMode() == "wal");
+	assert(db.synchronous() == 0);
+	assert(db.beginBulkLoad());
+
+	SQLConn::BatchResult res;
+	const std::vector<std::tuple<std::string_view>> streets { { "Bulk street" } };
+	assert(db.insertAddresses(streets, &res));
+	assert(res.affected == 1);
+
+	assert(db.endBulkLoad());
+	assert(db.hasIndex("person_age_index"));
+	assert(db.journalMode() == "delete");
+	assert(db.synchronous() == 2);
+	assert(db.endBulkLoad());
+}
+
+void testWriter(const std::filesystem::path &tmpDir)
+{
+	SQLConn db;
+	assert(db.open(tmpDir / "writer.db", OpenFlags::CREATE));
+	{
+		SQLWriter writer(db, 7, std::chrono::milliseconds(5), 16);
+		std::vector<std::thread> threads;
+		for (auto i = 0; i < 4; ++i)
+			threads.emplace_back([&writer, i]() {
+				for (auto j = 0; j < 25; ++j) {
+					auto street = "Writer street " + std::to_string(i * 100 + j);
+					writer.push([street](const SQLConn &db) {
+						return db.insertAddress(street);
+					});
+				}
+			});
+		for (auto &t : threads)
+			t.join();
+		assert(writer.flush());
+
+		writer.push([](const SQLConn &db) { return db.badInsertAddress("Bad street"); });
+		assert(!writer.flush());
+		Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << writer.lastError();
+		assert(writer.lastError().find("no index found") != std::string::npos);
+		assert(writer.flush());
+
+		writer.push([](const SQLConn &db) { return db.insertAddress("Good street"); });
+		writer.push([](const SQLConn &db) {
+			return db.insertAddress("Partial street") &&
+					db.badInsertAddress("Bad street");
+		});
+		assert(!writer.flush());
+		Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << writer.lastError();
+
+		writer.push([](const SQLConn &db) { return db.insertAddress("Last street"); });
+	}
+
+	assert(db.hasStreet("Good street"));
+	assert(!db.hasStreet("Partial street"));
+
+	std::vector<std::tuple<std::string_view>> streets { { "Last street" } };
+	SQLConn::BatchResult res;
+	assert(db.insertAddresses(streets, &res));
+	assert(res.uniqueConflicts == 1);
+	streets = { { "Writer street 324" } };
+	assert(db.insertAddresses(streets, &res));
+	assert(res.uniqueConflicts == 1);
+
+	{
+		SQLWriter writer(db, 7, std::chrono::milliseconds::zero());
+		for (auto i = 0; i < 10; ++i)
+			writer.push([i](const SQLConn &db) {
+				return db.insertAddress("Zero interval street " + std::to_string(i));
+			});
+		assert(writer.flush());
+	}
+	streets = { { "Zero interval street 9" } };
+	assert(db.insertAddresses(streets, &res));
+	assert(res.uniqueConflicts == 1);
+}
+
+void testTypes(const SQLConn &db)
+{
+	const std::array<std::byte, 4> oid1 {
+		std::byte(0xde), std::byte(0xad), std::byte(0), std::byte(0xef)
+	};
+	const std::array<std::byte, 2> oid2 { std::byte(1), std::byte(2) };
+	const int64_t big = 1LL << 40;
+
+	assert(db.insertObject(oid1, big, 0.5));
+	assert(db.insertObject(oid2, 10, std::nullopt));
+
+	auto resOpt = db.getObject(oid1);
+	assert(resOpt && resOpt->size() == 1);
+	const auto &row = resOpt->front();
+	const auto &blob = std::get<std::vector<std::byte>>(row[0]);
+	assert(std::ranges::equal(blob, oid1));
+	assert(std::get<int64_t>(row[1]) == big);
+	assert(std::get<double>(row[2]) == 0.5);
+
+	resOpt = db.getObject(oid2);
+	assert(resOpt && resOpt->size() == 1);
+	assert(std::get<int>(resOpt->front()[1]) == 10);
+	assert(std::holds_alternative<std::monostate>(resOpt->front()[2]));
+}
+
+void testBackup(const std::filesystem::path &tmpDir)
+{
+	const auto file = tmpDir / "backup.db";
+	SQLConn mem;
+	assert(mem.open(":memory:", OpenFlags::CREATE));
+	assert(mem.insertAddress("Memory street"));
+
+	unsigned steps = 0;
+	assert(mem.backupTo(file, [&steps](int remaining, int total) {
+		assert(remaining >= 0 && remaining <= total);
+		steps++;
+		return true;
+	}, 1));
+	assert(steps > 1);
+
+	assert(!mem.backupTo(tmpDir / "backup2.db", [](int, int) { return false; }, 1));
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << mem.lastError();
+
+	SQLConn mem2;
+	assert(mem2.open("file::memory:?cache=shared", OpenFlags::CREATE | OpenFlags::URI));
+	assert(mem2.restoreFrom(file));
+	const std::vector<std::tuple<std::string_view>> streets {
+		{ "Memory street" }, { "Memory street 2" }
+	};
+	SQLConn::BatchResult res;
+	assert(mem2.insertAddresses(streets, &res));
+	assert(res.affected == 1 && res.uniqueConflicts == 1);
+
+	assert(!mem2.restoreFrom(tmpDir / "nonexistent.db"));
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << mem2.lastError();
+
+	SQLConn src, locker;
+	assert(src.open(tmpDir / "locked.db", OpenFlags::CREATE));
+	assert(locker.open(tmpDir / "locked.db"));
+	src.setBusyPolicy({ .deadline = std::chrono::milliseconds(30) });
+	{
+		auto trans = locker.beginAuto(TransactionType::EXCLUSIVE);
+		assert(trans);
+		assert(!src.backupTo(tmpDir / "backup3.db"));
+		Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << src.lastError();
+		assert(src.lastErrorCode() == SQLITE_BUSY);
+	}
+	assert(src.backupTo(tmpDir / "backup3.db"));
+}
+
+void testBusy(const std::filesystem::path &tmpDir)
+{
+	const auto file = tmpDir / "busy.db";
+	SQLConn db1, db2;
+	assert(db1.open(file, OpenFlags::CREATE));
+	assert(db1.exec("PRAGMA journal_mode = WAL;"));
+	assert(db1.setAutoCheckpoint(0));
+	assert(db2.open(file));
+
+	db2.setBusyPolicy({ .initialDelay = std::chrono::microseconds(10),
+			    .maxDelay = std::chrono::microseconds(1000),
+			    .deadline = std::chrono::milliseconds(30) });
+	{
+		auto trans = db1.beginAuto(TransactionType::IMMEDIATE);
+		assert(trans);
+		assert(db1.insertAddress("Busy street"));
+		assert(!db2.insertAddress("Busy street 2"));
+		Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << db2.lastError();
+		assert(db2.lastErrorCode() == SQLITE_BUSY);
+	}
+
+	const auto &stats = db2.busyStats();
+	assert(stats.waits == 1);
+	assert(stats.timeouts == 1);
+	assert(stats.sleeps > 1);
+	assert(stats.waited.count() > 0);
+	assert(stats.maxWait >= std::chrono::milliseconds(30));
+
+	assert(db2.insertAddress("Busy street 2"));
+
+	int logFrames = -1, checkpointed = -1;
+	assert(db1.checkpoint(CheckpointMode::PASSIVE, &logFrames, &checkpointed));
+	assert(logFrames > 0 && checkpointed == logFrames);
+	assert(db1.checkpoint(CheckpointMode::TRUNCATE, &logFrames, &checkpointed));
+	assert(logFrames == 0);
+
+	auto moved = std::move(db2);
+	assert(moved.busyStats().waits == 1);
+	assert(db2.busyStats().waits == 0);
+	db2.setBusyPolicy({ .deadline = std::chrono::milliseconds(30) });
+	assert(db2.open(file));
+	assert(db2.insertAddress("Busy street 3"));
+}
+
+void testCursor(const SQLConn &db)
+{
+	unsigned rows = 0;
+	assert(db.forEachPerson("%", [&rows](const Select::RowView &row) {
+		assert(row.columns() == 3);
+		if (!rows) {
+			assert(row.getText(0) == people[0].name);
+			assert(row.getInt(1) == people[0].age);
+			assert(std::get<std::string_view>(row[2]) == people[0].addr);
+		}
+		rows++;
+		return true;
+	}));
+	assert(rows == persons);
+
+	rows = 0;
+	assert(db.forEachPerson("%", [&rows](const Select::RowView &) {
+		return ++rows < 2;
+	}));
+	assert(rows == 2);
+
+	/* the statement has to be reset after the early exit above */
+	rows = 0;
+	assert(db.forEachPerson(people[1].name, [&rows](const Select::RowView &row) {
+		assert(row.getText(0) == people[1].name);
+		return ++rows;
+	}));
+	assert(rows == 1);
+
+	assert(!db.badSelect());
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << db.lastError();
+	assert(db.lastError().find("no index found") != std::string::npos);
+}
+
+void testPool(const std::filesystem::path &tmpDir)
+{
+	SQLConnPool<SQLConn> pool;
+	assert(!pool.get() && !pool.tryGet());
+	assert(!pool.open(tmpDir / "nonexistent.db", 2));
+	Clr(std::cerr, Clr::GREEN) << "EXPECTED error: " << pool.lastError();
+	assert(!pool.get());
+
+	assert(pool.open(tmpDir / "sql.db", 2, OpenFlags::SHARED_CACHE));
+	assert(pool.size() == 2);
+
+	std::vector<std::thread> threads;
+	for (auto i = 0; i < 4; ++i)
+		threads.emplace_back([&pool]() {
+			for (auto j = 0; j < 10; ++j) {
+				auto conn = pool.get();
+				assert(conn);
+				auto res = (*conn)->getPersons("%");
+				assert(res && res->size() == persons);
+			}
+		});
+	for (auto &t : threads)
+		t.join();
+
+	auto c1 = pool.tryGet();
+	auto c2 = pool.tryGet();
+	assert(c1 && c2 && !pool.tryGet());
+	assert(!(*c1)->insertAddress("Read-only street"));
+	c2.reset();
+	assert(pool.tryGet());
+}
+
+void testProfile(SQLConn &db)
+{
+	assert(db.enableProfiling(std::chrono::milliseconds(1)));
+	for (auto i = 0; i < 3; ++i)
+		assert(db.getPersons("%"));
+	/* millions of VM steps: surely over the 1 ms threshold even with ms granularity */
+	assert(db.countTo(300000));
+	db.disableProfiling();
+	assert(db.getPersons("%"));
+
+	const auto prof = db.profile();
+	assert(prof.size() == 2);
+	assert(prof[0].sql.find("WITH RECURSIVE") == 0);
+	assert(prof[0].calls == 1);
+	assert(prof[0].slowCalls == 1);
+	assert(prof[0].max >= std::chrono::milliseconds(1));
+	assert(prof[1].sql.find("SELECT person.name") == 0);
+	assert(prof[1].calls == 3);
+	assert(prof[1].vmSteps > 0);
+	assert(prof[1].total >= prof[1].max);
+	db.dumpProfile(std::cerr);
+}
+
 void testAttach(const SQLConn &db)
 {
 	assert(db.attach("", "my_temp"));
@@ -295,11 +763,16 @@ int main()
 {
 	const auto tmpDir = THelpers::getTmpDir();
 	{
-		const auto db = testOpen(tmpDir);
+		auto db = testOpen(tmpDir);
 		testExec(db);
 		testInsert(db);
 		testTemp(db);
+		testTyped(db);
+		testTypes(db);
 		testSelect(db);
+		testCursor(db);
+		testPool(tmpDir);
+		testProfile(db);
 		testAttach(db);
 		testDelete(db);
 	}
@@ -309,6 +782,11 @@ int main()
 		assert(db.lastErrorCode() == SQLITE_ERROR);
 		assert(db.lastError().find("no such table: personTemp") != std::string::npos);
 	}
+	testBatch(tmpDir);
+	testBulkLoad(tmpDir);
+	testWriter(tmpDir);
+	testBackup(tmpDir);
+	testBusy(tmpDir);
 	std::filesystem::remove_all(tmpDir);
 
 	return 0;